@@ -0,0 +1,50 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * rBootDeltaOutputStream.cpp
+ *
+ ****/
+
+#include "rBootDeltaOutputStream.h"
+#include <esp_spi_flash.h>
+
+size_t rBootDeltaOutputStream::write(const uint8_t* data, size_t size)
+{
+	if(item == nullptr || patch.isError()) {
+		return 0;
+	}
+
+	if(!initialized && size > 0) {
+		// Target is always written from the start of the item
+		item->size = 0;
+		if(!init()) {
+			return 0;
+		}
+		patch.reset();
+		debug_d("rBootDelta: Source %X", item->sourceOffset);
+	}
+
+	item->hash.update(data, size);
+	item->size += size;
+
+	// Returning short aborts the request
+	return patch.write(data, size) ? size : 0;
+}
+
+bool rBootDeltaOutputStream::FlashPatch::readSource(uint32_t offset, uint8_t* buffer, size_t length)
+{
+	flashmem_read(buffer, stream.item->sourceOffset + offset, length);
+	return true;
+}
+
+bool rBootDeltaOutputStream::FlashPatch::writeTarget(const uint8_t* data, size_t length)
+{
+	if(!rboot_write_flash(&stream.rBootWriteStatus, const_cast<uint8_t*>(data), length)) {
+		debug_e("rboot_write_flash: Failed. Size: %d", length);
+		return false;
+	}
+	return true;
+}
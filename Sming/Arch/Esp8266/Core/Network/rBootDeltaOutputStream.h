@@ -0,0 +1,56 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * rBootDeltaOutputStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "rBootHttpUpdate.h"
+#include "Data/DeltaPatch.h"
+
+/** @brief Applies a delta patch as it is downloaded
+ *
+ *  The patch is created by Tools/rboot-delta.py from the image in the running ROM slot (the source)
+ *  and the new image. Unchanged data is copied from the source slot, so only the differences need
+ *  to be downloaded. Decoding and verification are done by DeltaPatch.
+ *
+ *  @note Patches cannot be resumed part way through, so an interrupted download starts again.
+ */
+class rBootDeltaOutputStream : public rBootItemOutputStream
+{
+public:
+	rBootDeltaOutputStream() : patch(*this)
+	{
+	}
+
+	size_t write(const uint8_t* data, size_t size) override;
+
+	bool isFinished() override
+	{
+		return patch.isFinished();
+	}
+
+private:
+	// Reads the source image from flash and writes the target using rBoot
+	class FlashPatch : public DeltaPatch
+	{
+	public:
+		FlashPatch(rBootDeltaOutputStream& stream) : stream(stream)
+		{
+		}
+
+	protected:
+		bool readSource(uint32_t offset, uint8_t* buffer, size_t length) override;
+		bool writeTarget(const uint8_t* data, size_t length) override;
+
+	private:
+		rBootDeltaOutputStream& stream;
+	};
+
+	FlashPatch patch;
+};
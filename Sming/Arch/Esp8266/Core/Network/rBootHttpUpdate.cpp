@@ -14,12 +14,28 @@
  */
 
 #include "rBootHttpUpdate.h"
+#include "rBootDeltaOutputStream.h"
 #include "Platform/System.h"
 #include "Network/Url.h"
 #include "Platform/WDT.h"
+#include <esp_spi_flash.h>
+#include <stringutil.h>
 
 /* rBootItemOutputStream */
 
+rBootItemOutputStream::~rBootItemOutputStream()
+{
+	close();
+
+	if(item != nullptr) {
+		// Request ended without completing, e.g. connection lost
+		item->stream = nullptr;
+		if(item->state == eRBIS_Downloading) {
+			item->state = eRBIS_Interrupted;
+		}
+	}
+}
+
 bool rBootItemOutputStream::init()
 {
 	if(item == nullptr) {
@@ -27,7 +43,8 @@ bool rBootItemOutputStream::init()
 		return false;
 	}
 
-	rBootWriteStatus = rboot_write_init(this->item->targetOffset);
+	// Continue from wherever the download is resuming
+	rBootWriteStatus = rboot_write_init(item->targetOffset + item->size);
 	initialized = true;
 
 	return true;
@@ -35,6 +52,11 @@ bool rBootItemOutputStream::init()
 
 size_t rBootItemOutputStream::write(const uint8_t* data, size_t size)
 {
+	if(item == nullptr) {
+		// Update has been abandoned
+		return 0;
+	}
+
 	if(!initialized && size > 0) {
 		if(!init()) { // unable to initialize
 			return -1;
@@ -48,6 +70,7 @@ size_t rBootItemOutputStream::write(const uint8_t* data, size_t size)
 		return -1;
 	}
 
+	item->hash.update(data, size);
 	item->size += size;
 
 	debug_d("rboot_write_flash: item.size: %d", item->size);
@@ -57,66 +80,301 @@ size_t rBootItemOutputStream::write(const uint8_t* data, size_t size)
 
 bool rBootItemOutputStream::close()
 {
+	if(!initialized) {
+		return true;
+	}
+
+	initialized = false;
 	return rboot_write_end(&rBootWriteStatus);
 }
 
 /* rBootHttpUpdate */
 
+rBootHttpUpdate::~rBootHttpUpdate()
+{
+	checkTimer.stop();
+	detachStreams();
+}
+
 void rBootHttpUpdate::addItem(int offset, String firmwareFileUrl)
 {
 	rBootHttpUpdateItem add;
 	add.targetOffset = offset;
 	add.url = firmwareFileUrl;
 	add.size = 0;
+	add.resumeOffset = 0;
+	add.attempts = 0;
+	add.state = eRBIS_Pending;
+	add.verify = false;
+	add.delta = false;
+	add.sourceOffset = 0;
+	add.stream = nullptr;
 	items.add(add);
 }
 
+void rBootHttpUpdate::addDeltaItem(int offset, const String& patchUrl, uint32_t sourceOffset)
+{
+	addItem(offset, patchUrl);
+	auto& it = items[items.count() - 1];
+	it.delta = true;
+	it.sourceOffset = sourceOffset;
+}
+
+rBootItemOutputStream* rBootHttpUpdate::getDeltaStream()
+{
+	return new rBootDeltaOutputStream();
+}
+
+bool rBootHttpUpdate::addItem(int offset, const String& firmwareFileUrl, const String& sha256)
+{
+	rBootHttpUpdateItem add;
+	if(sha256.length() != SHA256_SIZE * 2) {
+		debug_e("rBootHttpUpdate: Invalid SHA-256 '%s'", sha256.c_str());
+		return false;
+	}
+	for(unsigned i = 0; i < SHA256_SIZE; ++i) {
+		int hi = unhex(sha256[i * 2]);
+		int lo = unhex(sha256[i * 2 + 1]);
+		if(hi < 0 || lo < 0) {
+			debug_e("rBootHttpUpdate: Invalid SHA-256 '%s'", sha256.c_str());
+			return false;
+		}
+		add.sha256[i] = (hi << 4) | lo;
+	}
+
+	addItem(offset, firmwareFileUrl);
+	auto& it = items[items.count() - 1];
+	memcpy(it.sha256, add.sha256, SHA256_SIZE);
+	it.verify = true;
+	return true;
+}
+
 void rBootHttpUpdate::start()
 {
 	for(unsigned i = 0; i < items.count(); i++) {
 		rBootHttpUpdateItem& it = items[i];
-		debug_d("Download file:\r\n    (%d) %s -> %X", currentItem, it.url.c_str(), it.targetOffset);
-
-		HttpRequest* request;
-		if(baseRequest != nullptr) {
-			request = baseRequest->clone();
-			request->setURL(it.url);
-		} else {
-			request = new HttpRequest(it.url);
+		it.size = 0;
+		it.resumeOffset = 0;
+		it.attempts = 0;
+		it.state = eRBIS_Pending;
+		it.hash.reset();
+	}
+
+	checkTimer.setCallback(TimerDelegate(&rBootHttpUpdate::checkItems, this));
+	checkTimer.setIntervalMs(RBOOT_HTTP_UPDATE_RETRY_DELAY);
+	checkTimer.start();
+	startItems();
+}
+
+void rBootHttpUpdate::startItems()
+{
+	unsigned active = 0;
+	for(unsigned i = 0; i < items.count(); i++) {
+		if(items[i].state == eRBIS_Downloading) {
+			++active;
 		}
+	}
 
-		request->setMethod(HTTP_GET);
+	for(unsigned i = 0; i < items.count() && active < parallelDownloads; i++) {
+		rBootHttpUpdateItem& it = items[i];
+		if(it.state != eRBIS_Pending) {
+			continue;
+		}
 
-		rBootItemOutputStream* responseStream = getStream();
-		responseStream->setItem(&it);
+		if(!startItem(it)) {
+			// Leave the rest until the next check
+			break;
+		}
+		++active;
+	}
+}
 
-		request->setResponseStream(responseStream);
+bool rBootHttpUpdate::startItem(rBootHttpUpdateItem& it)
+{
+	// Resume from the last whole sector, as rboot erases each sector before writing to it
+	uint32_t resumeOffset = it.delta ? 0 : (it.size & ~(INTERNAL_FLASH_SECTOR_SIZE - 1));
+	if(resumeOffset > it.resumeOffset) {
+		it.attempts = 0;
+	}
+	it.resumeOffset = resumeOffset;
+	it.size = resumeOffset;
+	++it.attempts;
 
-		if(i == items.count() - 1) {
-			request->onRequestComplete(RequestCompletedDelegate(&rBootHttpUpdate::updateComplete, this));
-		} else {
-			request->onRequestComplete(RequestCompletedDelegate(&rBootHttpUpdate::itemComplete, this));
+	// Hash whatever has already been written
+	it.hash.reset();
+	uint32_t buffer[64];
+	for(uint32_t offset = 0; offset < resumeOffset; offset += sizeof(buffer)) {
+		flashmem_read(buffer, it.targetOffset + offset, sizeof(buffer));
+		it.hash.update(buffer, sizeof(buffer));
+		if(offset % INTERNAL_FLASH_SECTOR_SIZE == 0) {
+			WDT.alive();
 		}
+	}
 
-		if(!send(request)) {
-			debug_e("ERROR: Rejected sending new request.");
-			break;
+	debug_d("Download file:\r\n    %s -> %X, from %u, attempt %u", it.url.c_str(), it.targetOffset, resumeOffset,
+			it.attempts);
+
+	HttpRequest* request;
+	if(baseRequest != nullptr) {
+		request = baseRequest->clone();
+		request->setURL(it.url);
+	} else {
+		request = new HttpRequest(it.url);
+	}
+
+	request->setMethod(HTTP_GET);
+	if(resumeOffset != 0) {
+		request->setHeader(F("Range"), String(F("bytes=")) + resumeOffset + '-');
+	}
+
+	rBootItemOutputStream* responseStream = it.delta ? getDeltaStream() : getStream();
+	responseStream->setItem(&it);
+
+	request->setResponseStream(responseStream);
+	request->onHeadersComplete(RequestHeadersCompletedDelegate(&rBootHttpUpdate::itemHeadersComplete, this));
+	request->onRequestComplete(RequestCompletedDelegate(&rBootHttpUpdate::itemComplete, this));
+
+	it.state = eRBIS_Downloading;
+	if(!send(request)) {
+		// Request and stream have been deleted, which marks the item as interrupted
+		debug_e("ERROR: Rejected sending new request.");
+		return false;
+	}
+
+	return true;
+}
+
+void rBootHttpUpdate::checkItems()
+{
+	for(unsigned i = 0; i < items.count(); i++) {
+		rBootHttpUpdateItem& it = items[i];
+		if(it.state != eRBIS_Interrupted) {
+			continue;
+		}
+
+		if(it.attempts >= RBOOT_HTTP_UPDATE_MAX_ATTEMPTS) {
+			debug_e("Giving up on %s after %u attempts", it.url.c_str(), it.attempts);
+			updateFailed();
+			return;
 		}
+
+		debug_w("Resuming %s, %d bytes written", it.url.c_str(), it.size);
+		it.state = eRBIS_Pending;
 	}
+
+	startItems();
+}
+
+static rBootItemOutputStream* getItemStream(HttpConnection& client)
+{
+	// The stream moves from the request to the response once a body is expected
+	auto request = client.getRequest();
+	ReadWriteStream* stream = (request != nullptr) ? request->getResponseStream() : nullptr;
+	if(stream == nullptr) {
+		stream = client.getResponse()->buffer;
+	}
+	return static_cast<rBootItemOutputStream*>(stream);
+}
+
+/*
+ * Get the first byte position from a Content-Range header, "bytes start-end/total"
+ * Returns -1 if the value is missing or malformed.
+ */
+static int32_t getRangeStart(const HttpHeaders& headers)
+{
+	const String& value = headers[F("Content-Range")];
+	if(!value.startsWith(F("bytes "))) {
+		return -1;
+	}
+
+	const char* start = value.c_str() + 6;
+	char* end;
+	unsigned long pos = strtoul(start, &end, 10);
+	if(end == start || *end != '-' || pos > INT32_MAX) {
+		return -1;
+	}
+	return pos;
+}
+
+int rBootHttpUpdate::itemHeadersComplete(HttpConnection& client, HttpResponse& response)
+{
+	auto stream = getItemStream(client);
+	rBootHttpUpdateItem* it = (stream != nullptr) ? stream->getItem() : nullptr;
+	if(it == nullptr) {
+		return 0;
+	}
+
+	if(response.code != HTTP_STATUS_OK && response.code != HTTP_STATUS_PARTIAL_CONTENT) {
+		// Abort the request so error pages don't get written to flash
+		debug_e("HTTP status %d for %s", response.code, it->url.c_str());
+		return -1;
+	}
+
+	if(it->size != 0 && response.code != HTTP_STATUS_PARTIAL_CONTENT) {
+		debug_w("Server ignored Range, restarting %s", it->url.c_str());
+		it->size = 0;
+		it->hash.reset();
+	} else if(response.code == HTTP_STATUS_PARTIAL_CONTENT &&
+			  getRangeStart(response.headers) != int32_t(it->resumeOffset)) {
+		// Data would be written to the wrong place, so abort and ask for the whole file next time
+		debug_e("Content-Range does not match resume offset %u, restarting %s", it->resumeOffset, it->url.c_str());
+		it->size = 0;
+		it->hash.reset();
+		return -1;
+	}
+
+	return 0;
 }
 
 int rBootHttpUpdate::itemComplete(HttpConnection& client, bool success)
 {
+	auto stream = getItemStream(client);
+	rBootHttpUpdateItem* it = (stream != nullptr) ? stream->getItem() : nullptr;
+	if(it == nullptr) {
+		// Stream was abandoned, so the item has already been dealt with
+		return success ? 0 : -1;
+	}
+
+	stream->close();
+	stream->setItem(nullptr);
+	it->stream = nullptr;
+
+	if(success && !stream->isFinished()) {
+		debug_e("Incomplete download for %s", it->url.c_str());
+		success = false;
+	}
+
+	if(success && it->verify) {
+		uint8_t hash[SHA256_SIZE];
+		it->hash.getHash(hash);
+		if(memcmp(hash, it->sha256, SHA256_SIZE) != 0) {
+			debug_e("SHA-256 mismatch for %s, restarting", it->url.c_str());
+			it->size = 0;
+			success = false;
+		}
+	}
+
 	if(!success) {
-		updateFailed();
+		// checkItems() will resume it
+		it->state = eRBIS_Interrupted;
 		return -1;
 	}
 
-	return 0;
+	it->state = eRBIS_Complete;
+	for(unsigned i = 0; i < items.count(); i++) {
+		if(items[i].state != eRBIS_Complete) {
+			startItems();
+			return 0;
+		}
+	}
+
+	return updateComplete(client, true);
 }
 
 int rBootHttpUpdate::updateComplete(HttpConnection& client, bool success)
 {
+	checkTimer.stop();
+
 	debug_d("\r\nFirmware download finished!");
 	for(unsigned i = 0; i < items.count(); i++) {
 		debug_d(" - item: %d, addr: %X, len: %d bytes", i, items[i].targetOffset, items[i].size);
@@ -136,8 +394,22 @@ int rBootHttpUpdate::updateComplete(HttpConnection& client, bool success)
 	return 0;
 }
 
+void rBootHttpUpdate::detachStreams()
+{
+	// Any requests still in progress will be aborted by their streams
+	for(unsigned i = 0; i < items.count(); i++) {
+		if(items[i].stream != nullptr) {
+			items[i].stream->setItem(nullptr);
+			items[i].stream = nullptr;
+		}
+	}
+}
+
 void rBootHttpUpdate::updateFailed()
 {
+	checkTimer.stop();
+	detachStreams();
+
 	debug_e("\r\nFirmware download failed..");
 	if(updateDelegate) {
 		updateDelegate(*this, false);
@@ -17,31 +17,65 @@
 
 #include "Data/Stream/DataSourceStream.h"
 #include "Network/HttpClient.h"
+#include "Data/Sha256.h"
+#include "Timer.h"
 #include <rboot-api.h>
 
 #define NO_ROM_SWITCH 0xff
 
+/// Number of consecutive attempts without progress before an item download is abandoned
+#ifndef RBOOT_HTTP_UPDATE_MAX_ATTEMPTS
+#define RBOOT_HTTP_UPDATE_MAX_ATTEMPTS 5
+#endif
+
+/// Delay before resuming an interrupted item download, in milliseconds
+#ifndef RBOOT_HTTP_UPDATE_RETRY_DELAY
+#define RBOOT_HTTP_UPDATE_RETRY_DELAY 2000
+#endif
+
 class rBootHttpUpdate;
+class rBootItemOutputStream;
 
 typedef Delegate<void(rBootHttpUpdate& client, bool result)> OtaUpdateDelegate;
 
+enum rBootHttpUpdateItemState {
+	eRBIS_Pending,	 ///< Waiting to be (re)started
+	eRBIS_Downloading, ///< Request in progress
+	eRBIS_Interrupted, ///< Request failed or connection lost, will be resumed
+	eRBIS_Complete,	///< Downloaded and verified
+};
+
 struct rBootHttpUpdateItem {
 	String url;
 	uint32_t targetOffset;
-	int size;
+	int size;					   ///< Bytes received
+	uint32_t resumeOffset;		   ///< Where the last request started from
+	uint8_t attempts;			   ///< Consecutive attempts without progress
+	rBootHttpUpdateItemState state;
+	bool verify;				   ///< Set if sha256 contains the expected hash
+	bool delta;					   ///< Item is a patch to the image at sourceOffset
+	uint32_t sourceOffset;
+	uint8_t sha256[SHA256_SIZE];   ///< Expected hash
+	Sha256 hash;				   ///< Hash of data written so far
+	rBootItemOutputStream* stream; ///< Stream currently writing this item
 };
 
 class rBootItemOutputStream : public ReadWriteStream
 {
 public:
-	virtual ~rBootItemOutputStream()
-	{
-		close();
-	}
+	virtual ~rBootItemOutputStream();
 
 	void setItem(rBootHttpUpdateItem* item)
 	{
 		this->item = item;
+		if(item != nullptr) {
+			item->stream = this;
+		}
+	}
+
+	rBootHttpUpdateItem* getItem()
+	{
+		return item;
 	}
 
 	virtual bool init();
@@ -76,10 +110,45 @@ protected:
 	rboot_write_status rBootWriteStatus;
 };
 
+/** @brief Downloads firmware items to flash using rBoot
+ *
+ *  Interrupted downloads are resumed from the last whole flash sector written, using an HTTP Range
+ *  request, so a dropped connection doesn't mean starting the item again. A response whose Content-Range
+ *  doesn't start at the requested offset is abandoned and the item downloaded again in full. If an expected SHA-256
+ *  hash is given for an item it is calculated during the download and checked before the update is
+ *  considered complete. Items may also be downloaded as delta patches, see `addDeltaItem()`.
+ */
 class rBootHttpUpdate : protected HttpClient
 {
 public:
+	~rBootHttpUpdate();
+
 	void addItem(int offset, String firmwareFileUrl);
+
+	/** @brief Add an item which must be verified before switching ROM
+	 *  @param offset Flash address to write to
+	 *  @param firmwareFileUrl
+	 *  @param sha256 Expected hash, as 64 hex digits
+	 *  @retval bool false if the hash is invalid
+	 */
+	bool addItem(int offset, const String& firmwareFileUrl, const String& sha256);
+
+	/** @brief Add an item downloaded as a delta patch, created using Tools/rboot-delta.py
+	 *  @param offset Flash address to write the new image to
+	 *  @param patchUrl
+	 *  @param sourceOffset Flash address of the image the patch was made from, normally the running ROM
+	 */
+	void addDeltaItem(int offset, const String& patchUrl, uint32_t sourceOffset);
+
+	/** @brief Set how many items may be downloaded at once
+	 *  @param count Default is 1. Parallel requests to the same host are limited by
+	 *  HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST.
+	 */
+	void setParallelDownloads(uint8_t count)
+	{
+		parallelDownloads = (count == 0) ? 1 : count;
+	}
+
 	void start();
 
 	void switchToRom(uint8_t romSlot)
@@ -120,11 +189,19 @@ protected:
 	void applyUpdate();
 	void updateFailed();
 
+	void startItems();
+	bool startItem(rBootHttpUpdateItem& item);
+	void checkItems();
+	void detachStreams();
+
 	virtual rBootItemOutputStream* getStream()
 	{
 		return new rBootItemOutputStream();
 	}
 
+	virtual rBootItemOutputStream* getDeltaStream();
+
+	virtual int itemHeadersComplete(HttpConnection& client, HttpResponse& response);
 	virtual int itemComplete(HttpConnection& client, bool success);
 	virtual int updateComplete(HttpConnection& client, bool success);
 
@@ -134,6 +211,8 @@ protected:
 	rboot_write_status rBootWriteStatus;
 	uint8_t romSlot = NO_ROM_SWITCH;
 	OtaUpdateDelegate updateDelegate = nullptr;
+	uint8_t parallelDownloads = 1;
+	Timer checkTimer; ///< Resumes interrupted items
 
 	HttpRequest* baseRequest = nullptr;
 };
@@ -0,0 +1,327 @@
+#!/usr/bin/env python
+########################################################
+#
+#  Delta OTA patch generator for rBootHttpUpdate
+#
+#  Creates a patch which rBootDeltaOutputStream applies on the
+#  device, reading the old image from the running ROM slot and
+#  writing the new image to the slot being updated.
+#
+#  Usage:
+#    rboot-delta.py diff <old.bin> <new.bin> <patch>
+#    rboot-delta.py apply <old.bin> <patch> <new.bin>
+#
+########################################################
+#
+# Patch layout (little-endian):
+#
+#   Header:
+#     u32     magic "SDLT"
+#     u32     source (old image) size
+#     u32     target (new image) size
+#     u8[32]  SHA-256 of source
+#     u8[32]  SHA-256 of target
+#
+#   Records start with a byte containing the opcode in the top 3 bits and the
+#   argument in the lower 5 bits. Arguments of 31 or more are stored as 31, with
+#   the remainder following as a varint (LEB128). The device accepts varints of
+#   at most 4 bytes, so an argument can be no more than 31 + 2^28 - 1. Longer
+#   records are split: COPY, ADD and INSERT into consecutive records of the same
+#   type, SEEK into several smaller moves.
+#     END                   Patch complete
+#     COPY    length        Copy bytes from source
+#     ADD     length, data  Add each data byte to the next source byte
+#     INSERT  length, data  Output data, source position is unchanged
+#     SEEK    offset        Move source position, zigzag-encoded signed value
+#
+#   COPY and ADD advance the source position. As with bsdiff, code which has
+#   moved shows up as an ADD containing a few non-zero bytes where addresses
+#   have changed, rather than as new data.
+#
+
+from __future__ import print_function
+import hashlib
+import struct
+import sys
+
+MAGIC = 0x544C4453  # "SDLT"
+HEADER_FORMAT = "<III32s32s"
+
+OP_END = 0
+OP_COPY = 1
+OP_ADD = 2
+OP_INSERT = 3
+OP_SEEK = 4
+
+OP_SHIFT = 5
+ARG_MASK = 0x1f
+MAX_VARINT_BYTES = 4
+MAX_ARG = ARG_MASK + (1 << (7 * MAX_VARINT_BYTES)) - 1
+MAX_SEEK = MAX_ARG >> 1
+
+BLOCK_SIZE = 8      # Length of source blocks used to find matches
+INDEX_STEP = 4      # Index every INDEX_STEP'th source position
+INDEX_DEPTH = 8     # Maximum positions kept for each block
+MIN_MATCH = 16      # Shortest match worth changing alignment for
+SCORE_WINDOW = 64   # Bytes compared when deciding to change alignment
+MIN_COPY = 4        # Shortest run of unchanged bytes to encode as COPY
+
+
+def match_length(a, ai, b, bi, limit=None):
+    """Count matching bytes between a[ai:] and b[bi:]"""
+    n = min(len(a) - ai, len(b) - bi)
+    if limit is not None:
+        n = min(n, limit)
+    length = 0
+    chunk = 256
+    while length + chunk <= n and a[ai + length:ai + length + chunk] == b[bi + length:bi + length + chunk]:
+        length += chunk
+    while length < n and a[ai + length] == b[bi + length]:
+        length += 1
+    return length
+
+
+def build_index(src):
+    index = {}
+    for i in range(0, len(src) - BLOCK_SIZE + 1, INDEX_STEP):
+        key = bytes(src[i:i + BLOCK_SIZE])
+        positions = index.get(key)
+        if positions is None:
+            index[key] = [i]
+        elif len(positions) < INDEX_DEPTH:
+            positions.append(i)
+    return index
+
+
+def alignment_score(src, dst, pos, delta, length):
+    """Count bytes of dst[pos:pos+length] which match the source at the given alignment"""
+    score = 0
+    for i in range(pos, pos + length):
+        k = i + delta
+        if 0 <= k < len(src) and src[k] == dst[i]:
+            score += 1
+    return score
+
+
+def find_segments(src, dst):
+    """Split target into (start, end, delta) segments, delta is None for new data"""
+    index = build_index(src)
+    segments = []
+    start = 0
+    delta = None
+    pos = 0
+    while pos < len(dst):
+        # Carry on with the current alignment while it matches
+        if delta is not None and 0 <= pos + delta < len(src):
+            n = match_length(src, pos + delta, dst, pos)
+            if n != 0:
+                pos += n
+                continue
+
+        best_length = 0
+        best_delta = None
+        for p in index.get(bytes(dst[pos:pos + BLOCK_SIZE]), ()):
+            n = match_length(src, p, dst, pos)
+            if n > best_length:
+                best_length = n
+                best_delta = p - pos
+
+        if best_length >= MIN_MATCH:
+            # Only move if the current alignment is clearly worse, e.g. not just a changed address
+            window = min(best_length, SCORE_WINDOW)
+            if delta is None or alignment_score(src, dst, pos, delta, window) + MIN_MATCH // 2 < window:
+                if pos > start:
+                    segments.append((start, pos, delta))
+                start = pos
+                delta = best_delta
+                pos += best_length
+                continue
+
+        pos += 1
+
+    if pos > start:
+        segments.append((start, pos, delta))
+    return segments
+
+
+class PatchWriter:
+    def __init__(self):
+        self.data = bytearray()
+        self.source_pos = 0
+        self.insert = bytearray()
+
+    def varint(self, value):
+        while True:
+            b = value & 0x7f
+            value >>= 7
+            if value == 0:
+                self.data.append(b)
+                return
+            self.data.append(b | 0x80)
+
+    def record(self, op, value, payload=None):
+        self.flush_insert()
+        while value > MAX_ARG:
+            self.write_record(op, MAX_ARG, None if payload is None else payload[:MAX_ARG])
+            value -= MAX_ARG
+            if payload is not None:
+                payload = payload[MAX_ARG:]
+        self.write_record(op, value, payload)
+
+    def write_record(self, op, value, payload):
+        if value < ARG_MASK:
+            self.data.append((op << OP_SHIFT) | value)
+        else:
+            self.data.append((op << OP_SHIFT) | ARG_MASK)
+            self.varint(value - ARG_MASK)
+        if payload is not None:
+            self.data += payload
+
+    def add_insert(self, payload):
+        # Adjacent new data is combined into a single record
+        self.insert += payload
+
+    def flush_insert(self):
+        if len(self.insert) != 0:
+            insert = self.insert
+            self.insert = bytearray()
+            self.record(OP_INSERT, len(insert), insert)
+
+    def seek(self, pos):
+        offset = pos - self.source_pos
+        while offset != 0:
+            step = max(-MAX_SEEK, min(offset, MAX_SEEK))
+            self.record(OP_SEEK, (step << 1) if step >= 0 else ((-step << 1) - 1))
+            offset -= step
+        self.source_pos = pos
+
+    def aligned(self, src, dst, start, end, delta):
+        self.seek(start + delta)
+        pos = start
+        while pos < end:
+            n = match_length(src, pos + delta, dst, pos, end - pos)
+            if n >= MIN_COPY or pos + n == end:
+                self.record(OP_COPY, n)
+                pos += n
+                continue
+
+            # Gather changed bytes up to the next unchanged run
+            add_end = pos + n + 1
+            while add_end < end:
+                if match_length(src, add_end + delta, dst, add_end, MIN_COPY) == min(MIN_COPY, end - add_end):
+                    break
+                add_end += 1
+            payload = bytearray((dst[i] - src[i + delta]) & 0xff for i in range(pos, add_end))
+            self.record(OP_ADD, len(payload), payload)
+            pos = add_end
+
+        self.source_pos = end + delta
+
+    def end(self):
+        self.record(OP_END, 0)
+
+
+def make_patch(src, dst):
+    writer = PatchWriter()
+    for start, end, delta in find_segments(src, dst):
+        if delta is None:
+            writer.add_insert(dst[start:end])
+            continue
+
+        # Parts which fall outside the source must be inserted
+        a = min(max(start, -delta), end)
+        b = max(min(end, len(src) - delta), a)
+        writer.add_insert(dst[start:a])
+        if b > a:
+            writer.aligned(src, dst, a, b, delta)
+        writer.add_insert(dst[b:end])
+
+    writer.end()
+    header = struct.pack(HEADER_FORMAT, MAGIC, len(src), len(dst), hashlib.sha256(src).digest(),
+                         hashlib.sha256(dst).digest())
+    return bytearray(header) + writer.data
+
+
+def apply_patch(src, patch):
+    magic, source_size, target_size, source_hash, target_hash = struct.unpack_from(HEADER_FORMAT, bytes(patch))
+    if magic != MAGIC:
+        raise ValueError("Not a delta patch")
+    if source_size != len(src) or hashlib.sha256(src).digest() != source_hash:
+        raise ValueError("Patch was not made from this image")
+
+    pos = struct.calcsize(HEADER_FORMAT)
+    source_pos = 0
+    dst = bytearray()
+    while True:
+        op = patch[pos] >> OP_SHIFT
+        value = patch[pos] & ARG_MASK
+        pos += 1
+        if value == ARG_MASK:
+            shift = 0
+            while True:
+                if shift == 7 * MAX_VARINT_BYTES:
+                    raise ValueError("Argument too long at %u" % pos)
+                b = patch[pos]
+                pos += 1
+                value += (b & 0x7f) << shift
+                shift += 7
+                if b & 0x80 == 0:
+                    break
+
+        if op == OP_END:
+            break
+        elif op == OP_COPY:
+            dst += src[source_pos:source_pos + value]
+            source_pos += value
+        elif op == OP_ADD:
+            dst += bytearray((src[source_pos + i] + patch[pos + i]) & 0xff for i in range(value))
+            source_pos += value
+            pos += value
+        elif op == OP_INSERT:
+            dst += patch[pos:pos + value]
+            pos += value
+        elif op == OP_SEEK:
+            source_pos += (value >> 1) if value & 1 == 0 else -((value + 1) >> 1)
+        else:
+            raise ValueError("Bad opcode %u at %u" % (op, pos - 1))
+
+    if len(dst) != target_size or hashlib.sha256(dst).digest() != target_hash:
+        raise ValueError("Patched image is corrupt")
+    return dst
+
+
+def read_file(filename):
+    with open(filename, "rb") as f:
+        return bytearray(f.read())
+
+
+def write_file(filename, data):
+    with open(filename, "wb") as f:
+        f.write(data)
+
+
+def main():
+    if len(sys.argv) != 5 or sys.argv[1] not in ("diff", "apply"):
+        print("Usage:\n\t%s diff <old.bin> <new.bin> <patch>\n\t%s apply <old.bin> <patch> <new.bin>" %
+              (sys.argv[0], sys.argv[0]))
+        sys.exit(1)
+
+    src = read_file(sys.argv[2])
+    if sys.argv[1] == "apply":
+        write_file(sys.argv[4], apply_patch(src, read_file(sys.argv[3])))
+        return
+
+    dst = read_file(sys.argv[3])
+    patch = make_patch(src, dst)
+
+    # Check the patch before anything is sent to a device
+    if apply_patch(src, patch) != dst:
+        print("Patch verification failed", file=sys.stderr)
+        sys.exit(1)
+
+    write_file(sys.argv[4], patch)
+    print("%s: %u bytes, %u%% of %u" % (sys.argv[4], len(patch), len(patch) * 100 // max(len(dst), 1), len(dst)))
+
+
+if __name__ == "__main__":
+    main()
@@ -428,6 +428,32 @@ flashinit: ##Erase your device's flash memory and reset system configuration are
 	$(ERASE_FLASH)
 	$(WRITE_FLASH) $(FLASH_INIT_CHUNKS)
 
+##@Tools
+
+# Delta OTA patches, applied by rBootHttpUpdate::addDeltaItem()
+# A patch is made from the image the device is running to the new image for the slot being updated.
+# With RBOOT_TWO_ROMS=1 each slot has its own image, so rom0.delta is made from the previous ROM 1
+# image and rom1.delta from the previous ROM 0 image.
+CONFIG_VARS += OTA_DELTA_BASE OTA_DELTA_BASE_1
+OTA_DELTA_BASE ?=
+OTA_DELTA_BASE_1 ?=
+.PHONY: otadelta
+otadelta: all ##Create delta OTA patches from previous images, e.g. `make otadelta OTA_DELTA_BASE=/path/to/old/rom0.bin OTA_DELTA_BASE_1=/path/to/old/rom1.bin`
+	$(Q) if [ -z "$(OTA_DELTA_BASE)" ]; then \
+		echo "Please set OTA_DELTA_BASE to the previous ROM 0 image"; \
+		exit 1; \
+	fi
+ifeq (,$(RBOOT_ROM_1))
+	$(Q) python $(ARCH_TOOLS)/rboot-delta.py diff $(OTA_DELTA_BASE) $(RBOOT_ROM_0) $(basename $(RBOOT_ROM_0)).delta
+else
+	$(Q) if [ -z "$(OTA_DELTA_BASE_1)" ]; then \
+		echo "Please set OTA_DELTA_BASE_1 to the previous ROM 1 image"; \
+		exit 1; \
+	fi
+	$(Q) python $(ARCH_TOOLS)/rboot-delta.py diff $(OTA_DELTA_BASE_1) $(RBOOT_ROM_0) $(basename $(RBOOT_ROM_0)).delta
+	$(Q) python $(ARCH_TOOLS)/rboot-delta.py diff $(OTA_DELTA_BASE) $(RBOOT_ROM_1) $(basename $(RBOOT_ROM_1)).delta
+endif
+
 ##@Cleaning
 
 .PHONY: clean
@@ -31,6 +31,9 @@ void host_init_tasks();
 // Hook function to process task queues
 void host_service_tasks();
 
+// Check if any task queue has events waiting to be processed
+bool host_tasks_pending();
+
 typedef void (*host_task_callback_t)(uint32_t param);
 
 void host_queue_callback(host_task_callback_t callback, uint32_t param);
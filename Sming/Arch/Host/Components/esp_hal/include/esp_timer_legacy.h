@@ -8,11 +8,12 @@ extern "C" {
 typedef void os_timer_func_t(void* timer_arg);
 
 struct os_timer_t {
-	struct os_timer_t* timer_next;
+	struct os_timer_t* timer_next; ///< Unused, retained for compatibility with SDK structure
 	uint32_t timer_expire;
 	uint32_t timer_period;
 	os_timer_func_t* timer_func;
 	void* timer_arg;
+	unsigned timer_index; ///< Position in timer queue, only valid whilst armed
 };
 
 void os_timer_arm(struct os_timer_t* ptimer, uint32_t time, bool repeat_flag);
@@ -23,6 +24,15 @@ void os_timer_setfn(struct os_timer_t* ptimer, os_timer_func_t* pfunction, void*
 // Hook function to service timers
 void host_service_timers();
 
+/*
+ * Get time until next timer is due
+ * Returns 0 if a timer has expired, UINT32_MAX if no timers are armed
+ */
+uint32_t host_timer_sleeptime();
+
+// Get number of armed timers
+unsigned host_timer_count();
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,5 +1,6 @@
 #include "include/esp_tasks.h"
 #include <hostlib/hostmsg.h>
+#include <hostlib/eventloop.h>
 #include <stringutil.h>
 
 struct task_queue_t {
@@ -61,7 +62,12 @@ bool system_os_post(uint8_t prio, os_signal_t sig, os_param_t par)
 		return false;
 	}
 
-	return task_queues[prio].post(sig, par);
+	if(!task_queues[prio].post(sig, par)) {
+		return false;
+	}
+
+	host_event_notify();
+	return true;
 }
 
 void host_init_tasks()
@@ -78,6 +84,16 @@ void host_init_tasks()
 		events, ARRAY_SIZE(events));
 }
 
+bool host_tasks_pending()
+{
+	for(auto& queue : task_queues) {
+		if(queue.count != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
 void host_service_tasks()
 {
 	for(int prio = HOST_TASK_PRIO; prio >= 0; --prio) {
@@ -87,5 +103,7 @@ void host_service_tasks()
 
 void host_queue_callback(host_task_callback_t callback, uint32_t param)
 {
-	task_queues[HOST_TASK_PRIO].post(os_signal_t(callback), param);
+	if(task_queues[HOST_TASK_PRIO].post(os_signal_t(callback), param)) {
+		host_event_notify();
+	}
 }
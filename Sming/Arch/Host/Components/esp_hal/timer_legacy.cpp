@@ -1,9 +1,81 @@
-
 #include "include/esp_system.h"
 #include "include/esp_timer_legacy.h"
+#include <vector>
+
+/*
+ * Armed timers are kept in a binary min-heap ordered by expiry time, so arming and disarming
+ * are O(log n) and finding the next timer due is O(1).
+ *
+ * Each timer records its position in the heap so it can be removed directly. Timers which have never
+ * been armed may contain garbage, so the index is always checked against the heap contents before use.
+ *
+ * Expiry times are compared using wrapped (signed) arithmetic; this is valid for intervals of up to
+ * 2^31 microseconds (about 35 minutes), well beyond the maximum os_timer interval used by Sming.
+ */
+static std::vector<os_timer_t*> timer_heap;
+
+static bool expires_before(const os_timer_t* t1, const os_timer_t* t2)
+{
+	return int32_t(t1->timer_expire - t2->timer_expire) < 0;
+}
+
+static void heap_set(unsigned index, os_timer_t* ptimer)
+{
+	timer_heap[index] = ptimer;
+	ptimer->timer_index = index;
+}
+
+static void sift_up(unsigned index)
+{
+	auto ptimer = timer_heap[index];
+	while(index > 0) {
+		unsigned parent = (index - 1) / 2;
+		if(!expires_before(ptimer, timer_heap[parent])) {
+			break;
+		}
+		heap_set(index, timer_heap[parent]);
+		index = parent;
+	}
+	heap_set(index, ptimer);
+}
 
-// Dummy timer, never gets used just makes code simpler
-static os_timer_t timer_head = {0};
+static void sift_down(unsigned index)
+{
+	auto ptimer = timer_heap[index];
+	unsigned count = timer_heap.size();
+	for(;;) {
+		unsigned child = index * 2 + 1;
+		if(child >= count) {
+			break;
+		}
+		if(child + 1 < count && expires_before(timer_heap[child + 1], timer_heap[child])) {
+			++child;
+		}
+		if(!expires_before(timer_heap[child], ptimer)) {
+			break;
+		}
+		heap_set(index, timer_heap[child]);
+		index = child;
+	}
+	heap_set(index, ptimer);
+}
+
+static bool is_armed(const os_timer_t* ptimer)
+{
+	return ptimer->timer_index < timer_heap.size() && timer_heap[ptimer->timer_index] == ptimer;
+}
+
+static void heap_remove(unsigned index)
+{
+	auto last = timer_heap.back();
+	timer_heap.pop_back();
+	if(index == timer_heap.size()) {
+		return;
+	}
+	heap_set(index, last);
+	sift_up(index);
+	sift_down(last->timer_index);
+}
 
 void os_timer_arm(struct os_timer_t* ptimer, uint32_t time, bool repeat_flag)
 {
@@ -13,24 +85,17 @@ void os_timer_arm(struct os_timer_t* ptimer, uint32_t time, bool repeat_flag)
 void os_timer_arm_us(struct os_timer_t* ptimer, uint32_t time, bool repeat_flag)
 {
 	os_timer_disarm(ptimer);
-	auto t = &timer_head;
-	while(t->timer_next != nullptr) {
-		t = t->timer_next;
-	}
 	ptimer->timer_next = nullptr;
 	ptimer->timer_expire = system_get_time() + time;
 	ptimer->timer_period = repeat_flag ? time : 0;
-	t->timer_next = ptimer;
+	timer_heap.push_back(ptimer);
+	sift_up(timer_heap.size() - 1);
 }
 
 void os_timer_disarm(struct os_timer_t* ptimer)
 {
-	auto t_prev = &timer_head;
-	for(auto t = t_prev->timer_next; t != nullptr; t_prev = t, t = t->timer_next) {
-		if(t == ptimer) {
-			t_prev->timer_next = t->timer_next;
-			break;
-		}
+	if(is_armed(ptimer)) {
+		heap_remove(ptimer->timer_index);
 	}
 }
 
@@ -45,18 +110,37 @@ void os_timer_setfn(struct os_timer_t* ptimer, os_timer_func_t* pfunction, void*
 void host_service_timers()
 {
 	auto time_now = system_get_time();
-	auto t_prev = &timer_head;
-	for(auto t = t_prev->timer_next; t != nullptr; t_prev = t, t = t->timer_next) {
-		if(t->timer_expire > time_now) {
-			continue;
+	while(!timer_heap.empty()) {
+		auto t = timer_heap[0];
+		if(int32_t(t->timer_expire - time_now) > 0) {
+			break;
 		}
+
+		// Reschedule before invoking callback, which may re-arm or disarm this timer
 		if(t->timer_period == 0) {
-			// Non-repeating timer, remove now
-			t_prev->timer_next = t->timer_next;
+			heap_remove(0);
+		} else {
+			t->timer_expire = time_now + t->timer_period;
+			sift_down(0);
 		}
+
 		if(t->timer_func != nullptr) {
 			t->timer_func(t->timer_arg);
 		}
-		t->timer_expire = time_now + t->timer_period;
 	}
 }
+
+uint32_t host_timer_sleeptime()
+{
+	if(timer_heap.empty()) {
+		return UINT32_MAX;
+	}
+
+	int32_t sleeptime = timer_heap[0]->timer_expire - system_get_time();
+	return (sleeptime > 0) ? sleeptime : 0;
+}
+
+unsigned host_timer_count()
+{
+	return timer_heap.size();
+}
@@ -0,0 +1,206 @@
+/**
+ * eventloop.cpp
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#include "eventloop.h"
+#include "hostmsg.h"
+#include "threads.h"
+#include <string.h>
+#include <errno.h>
+
+static pthread_t main_thread;
+
+static bool is_main_thread()
+{
+	return pthread_equal(pthread_self(), main_thread);
+}
+
+#ifdef __linux__
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+static int epoll_fd = -1;
+static int notify_fd = -1;
+static int timer_fd = -1;
+
+static bool add_fd(int fd)
+{
+	struct epoll_event ev = {};
+	ev.events = EPOLLIN;
+	ev.data.fd = fd;
+	if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		hostmsg("epoll_ctl(%d): %s", fd, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+// Consume an eventfd or timerfd count so it's no longer readable
+static void drain_fd(int fd)
+{
+	uint64_t count;
+	while(read(fd, &count, sizeof(count)) > 0) {
+		//
+	}
+}
+
+bool host_event_init(void)
+{
+	main_thread = pthread_self();
+
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if(epoll_fd < 0 || notify_fd < 0 || timer_fd < 0) {
+		hostmsg("Event initialisation failed: %s", strerror(errno));
+		host_event_shutdown();
+		return false;
+	}
+
+	if(!add_fd(notify_fd) || !add_fd(timer_fd)) {
+		host_event_shutdown();
+		return false;
+	}
+
+	return true;
+}
+
+void host_event_shutdown(void)
+{
+	auto close_fd = [](int& fd) {
+		if(fd >= 0) {
+			close(fd);
+			fd = -1;
+		}
+	};
+
+	close_fd(timer_fd);
+	close_fd(notify_fd);
+	close_fd(epoll_fd);
+}
+
+bool host_event_add_fd(int fd)
+{
+	return epoll_fd >= 0 && add_fd(fd);
+}
+
+void host_event_remove_fd(int fd)
+{
+	if(epoll_fd >= 0) {
+		epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+	}
+}
+
+void host_event_notify(void)
+{
+	if(notify_fd < 0 || is_main_thread()) {
+		return;
+	}
+
+	uint64_t count = 1;
+	(void)write(notify_fd, &count, sizeof(count));
+}
+
+void host_event_wait(uint32_t timeout_us)
+{
+	if(timeout_us == 0 || epoll_fd < 0) {
+		return;
+	}
+
+	if(timeout_us != HOST_EVENT_WAIT_INFINITE) {
+		struct itimerspec its = {};
+		its.it_value.tv_sec = timeout_us / 1000000U;
+		its.it_value.tv_nsec = (timeout_us % 1000000U) * 1000U;
+		timerfd_settime(timer_fd, 0, &its, nullptr);
+	}
+
+	// Readable descriptors are serviced by their owners, we just need to know when to wake up
+	struct epoll_event events[8];
+	int n = epoll_wait(epoll_fd, events, ARRAY_SIZE(events), -1);
+	for(int i = 0; i < n; ++i) {
+		int fd = events[i].data.fd;
+		if(fd == notify_fd || fd == timer_fd) {
+			drain_fd(fd);
+		}
+	}
+
+	if(timeout_us != HOST_EVENT_WAIT_INFINITE) {
+		struct itimerspec its = {};
+		timerfd_settime(timer_fd, 0, &its, nullptr);
+		drain_fd(timer_fd);
+	}
+}
+
+#else
+
+#include <time.h>
+
+static CSemaphore* notify_sem;
+
+bool host_event_init(void)
+{
+	main_thread = pthread_self();
+	notify_sem = new CSemaphore;
+	return true;
+}
+
+void host_event_shutdown(void)
+{
+	delete notify_sem;
+	notify_sem = nullptr;
+}
+
+bool host_event_add_fd(int fd)
+{
+	(void)fd;
+	return false;
+}
+
+void host_event_remove_fd(int fd)
+{
+	(void)fd;
+}
+
+void host_event_notify(void)
+{
+	if(notify_sem != nullptr && !is_main_thread()) {
+		notify_sem->post();
+	}
+}
+
+void host_event_wait(uint32_t timeout_us)
+{
+	if(timeout_us == 0 || notify_sem == nullptr) {
+		return;
+	}
+
+	if(timeout_us == HOST_EVENT_WAIT_INFINITE) {
+		notify_sem->wait();
+	} else {
+		notify_sem->timedwait(timeout_us / 1000U + 1);
+	}
+
+	// Multiple notifications only need to wake us once
+	while(notify_sem->trywait()) {
+		//
+	}
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * eventloop.h - Support for blocking the main emulator loop until there's something to do
+ *
+ * Copyright 2019 mikee47 <mike@sillyhouse.net>
+ *
+ * This file is part of the Sming Framework Project
+ *
+ * This library is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, version 3 or later.
+ *
+ * This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along with SHEM.
+ * If not, see <https://www.gnu.org/licenses/>.
+ *
+ ****/
+
+#pragma once
+
+#include "hostlib.h"
+
+/*
+ * Rather than spinning, the main loop calls host_event_wait() with the time until the next
+ * software timer or LWIP timeout is due. The wait completes early if:
+ *
+ * 	- a registered file descriptor (e.g. the TAP network interface) becomes readable
+ * 	- another thread (e.g. a UART server) calls host_event_notify(), typically by posting a task
+ * 	- a signal is received
+ *
+ * On Linux this uses epoll, with a timerfd for microsecond timeouts and an eventfd for notifications.
+ * Other platforms fall back to a semaphore wait and do not support file descriptors.
+ */
+
+#define HOST_EVENT_WAIT_INFINITE UINT32_MAX
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Initialise event handling, must be called from the main loop thread
+ * @retval bool false on failure, in which case waits return immediately
+ */
+bool host_event_init(void);
+
+void host_event_shutdown(void);
+
+/**
+ * @brief Wake the main loop if it's waiting for events when a file descriptor becomes readable
+ * @param fd
+ * @retval bool false if not supported on this platform
+ */
+bool host_event_add_fd(int fd);
+
+void host_event_remove_fd(int fd);
+
+/**
+ * @brief Wake the main loop
+ * @note Has no effect when called from the main loop thread itself, as pending work
+ * is always checked before waiting
+ */
+void host_event_notify(void);
+
+/**
+ * @brief Block until an event occurs or the timeout expires
+ * @param timeout_us Maximum time to wait in microseconds, or HOST_EVENT_WAIT_INFINITE
+ */
+void host_event_wait(uint32_t timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
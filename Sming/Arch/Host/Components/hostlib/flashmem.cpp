@@ -19,17 +19,72 @@
 
 #include "flashmem.h"
 #include <string.h>
+#include <algorithm>
 #include <esp_spi_flash.h>
 
+#ifndef __WIN32
+#include <sys/mman.h>
+#endif
+
 static int flashFile = -1;
 static size_t flashFileSize = 0x400000U;
 static const char* flashFileName = "flash.bin";
+static uint8_t* flashMemory; ///< Backing file mapped into memory, if supported
+static unsigned eraseCount;
 
 #define SPI_FLASH_SEC_SIZE 4096
 
 #define CHECK_ALIGNMENT(_x) assert(((uint32_t)(_x)&0x00000003) == 0)
 #define CHECK_RANGE(_addr, _size) assert((_addr) + (_size) <= flashFileSize);
 
+/*
+ * Where possible the backing file is memory-mapped, so reads and writes are simple memory operations
+ * rather than system calls. Windows (MinGW) falls back to regular file I/O.
+ */
+static void mapFlashFile()
+{
+#ifndef __WIN32
+	void* mem = mmap(nullptr, flashFileSize, PROT_READ | PROT_WRITE, MAP_SHARED, flashFile, 0);
+	if(mem == MAP_FAILED) {
+		hostmsg("Unable to map \"%s\", using file I/O", flashFileName);
+	} else {
+		flashMemory = static_cast<uint8_t*>(mem);
+	}
+#endif
+}
+
+static void unmapFlashFile()
+{
+#ifndef __WIN32
+	if(flashMemory != nullptr) {
+		msync(flashMemory, flashFileSize, MS_SYNC);
+		munmap(flashMemory, flashFileSize);
+		flashMemory = nullptr;
+	}
+#endif
+}
+
+/*
+ * Erased flash reads as 0xFF. Extending the file with ftruncate() would fill it with zeroes instead,
+ * and as writes only clear bits nothing written there could be read back.
+ */
+static bool fillFlashFile(size_t size)
+{
+	uint8_t buffer[SPI_FLASH_SEC_SIZE];
+	memset(buffer, 0xFF, sizeof(buffer));
+	if(lseek(flashFile, 0, SEEK_SET) != 0) {
+		return false;
+	}
+	while(size != 0) {
+		size_t len = std::min(size, sizeof(buffer));
+		if(write(flashFile, buffer, len) != int(len)) {
+			return false;
+		}
+		size -= len;
+	}
+	return true;
+}
+
 bool host_flashmem_init(const FlashmemConfig& config)
 {
 	if(config.filename != NULL) {
@@ -50,32 +105,42 @@ bool host_flashmem_init(const FlashmemConfig& config)
 
 	if(res == 0) {
 		size_t size = config.createSize ?: flashFileSize;
-		res = lseek(flashFile, size, SEEK_SET);
-		if(res != int(size)) {
-			hostmsg("Error seeking beyond end of file \"%s\"", flashFileName);
-		} else if(ftruncate(flashFile, size) < 0) {
-			hostmsg("Error truncating \"%s\" to %u bytes", flashFileName, size);
-		} else {
+		if(fillFlashFile(size)) {
 			hostmsg("Created blank \"%s\", %u bytes", flashFileName, size);
+		} else {
+			hostmsg("Error writing %u bytes to \"%s\"", size, flashFileName);
 		}
+		res = lseek(flashFile, 0, SEEK_END);
 	} else {
 		hostmsg("Opened \"%s\", size = 0x%08x", flashFileName, res);
 	}
 
 	flashFileSize = res;
 
+	mapFlashFile();
+
 	return true;
 }
 
+const char* host_flashmem_get_filename()
+{
+	return flashFileName;
+}
+
 void host_flashmem_cleanup()
 {
+	unmapFlashFile();
 	close(flashFile);
 	flashFile = -1;
-	hostmsg("Closed \"%s\"", flashFileName);
+	hostmsg("Closed \"%s\", %u sectors erased", flashFileName, eraseCount);
 }
 
 static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 {
+	if(flashMemory != nullptr) {
+		memcpy(buffer, flashMemory + offset, count);
+		return count;
+	}
 	if(flashFile < 0) {
 		return -1;
 	}
@@ -83,13 +148,70 @@ static int readFlashFile(uint32_t offset, void* buffer, size_t count)
 	return (res < 0) ? res : read(flashFile, buffer, count);
 }
 
+/*
+ * Emulate NOR flash behaviour: programming can only clear bits (1 -> 0), only erasing sets them.
+ * So writing to a location which hasn't been erased produces the same result as real hardware.
+ */
 static int writeFlashFile(uint32_t offset, const void* data, size_t count)
 {
+	auto src = static_cast<const uint8_t*>(data);
+
+	if(flashMemory != nullptr) {
+		auto dst = flashMemory + offset;
+		for(size_t i = 0; i < count; ++i) {
+			dst[i] &= src[i];
+		}
+		return count;
+	}
+
 	if(flashFile < 0) {
 		return -1;
 	}
+
+	uint8_t buffer[512];
+	size_t written = 0;
+	while(written < count) {
+		size_t len = std::min(count - written, sizeof(buffer));
+		int res = readFlashFile(offset + written, buffer, len);
+		if(res != int(len)) {
+			return -1;
+		}
+		for(size_t i = 0; i < len; ++i) {
+			buffer[i] &= src[written + i];
+		}
+		res = lseek(flashFile, offset + written, SEEK_SET);
+		if(res >= 0) {
+			res = write(flashFile, buffer, len);
+		}
+		if(res != int(len)) {
+			return -1;
+		}
+		written += len;
+	}
+
+	return written;
+}
+
+static bool eraseFlashFile(uint32_t offset, size_t count)
+{
+	++eraseCount;
+
+	if(flashMemory != nullptr) {
+		memset(flashMemory + offset, 0xFF, count);
+#ifndef __WIN32
+		msync(flashMemory + offset, count, MS_ASYNC);
+#endif
+		return true;
+	}
+
+	if(flashFile < 0) {
+		return false;
+	}
+
+	uint8_t tmp[INTERNAL_FLASH_SECTOR_SIZE];
+	memset(tmp, 0xFF, sizeof(tmp));
 	int res = lseek(flashFile, offset, SEEK_SET);
-	return (res < 0) ? res : write(flashFile, data, count);
+	return res >= 0 && write(flashFile, tmp, count) == int(count);
 }
 
 //SPIFlashInfo flashmem_get_info()
@@ -150,7 +272,5 @@ bool flashmem_erase_sector(uint32_t sector_id)
 {
 	uint32_t addr = sector_id * INTERNAL_FLASH_SECTOR_SIZE;
 	CHECK_RANGE(addr, INTERNAL_FLASH_SECTOR_SIZE);
-	uint8_t tmp[INTERNAL_FLASH_SECTOR_SIZE];
-	memset(tmp, 0xFF, sizeof(tmp));
-	return writeFlashFile(addr, tmp, sizeof(tmp)) == sizeof(tmp);
+	return eraseFlashFile(addr, INTERNAL_FLASH_SECTOR_SIZE);
 }
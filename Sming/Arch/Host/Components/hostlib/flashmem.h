@@ -36,4 +36,9 @@ struct FlashmemConfig {
  */
 bool host_flashmem_init(const FlashmemConfig& config);
 
+/**
+ * @brief Get the path to the flash backing file
+ */
+const char* host_flashmem_get_filename();
+
 void host_flashmem_cleanup();
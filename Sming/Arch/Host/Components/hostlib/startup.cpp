@@ -25,6 +25,7 @@
 #include "options.h"
 #include "flashmem.h"
 #include "uart_server.h"
+#include "eventloop.h"
 #include <BitManipulations.h>
 #include <esp_timer_legacy.h>
 #include <esp_tasks.h>
@@ -45,6 +46,7 @@ static void cleanup()
 	CUartServer::shutdown();
 	sockets_finalise();
 	host_lwip_shutdown();
+	host_event_shutdown();
 	hostmsg("Goodbye!");
 }
 
@@ -87,6 +89,26 @@ static size_t parse_flash_size(const char* str)
 	}
 }
 
+/*
+ * Sleep until there's something to do: a queued task, an expired timer or LWIP timeout,
+ * an incoming network packet or a notification from another thread (e.g. UART server).
+ */
+static void wait_for_events()
+{
+	if(host_tasks_pending()) {
+		return;
+	}
+
+	uint32_t timeout = host_timer_sleeptime();
+	uint32_t lwip_ms = host_lwip_sleeptime();
+	// Compare in microseconds, dividing the timer value would wake up to 1ms late
+	if(uint64_t(lwip_ms) * 1000U < timeout) {
+		timeout = lwip_ms * 1000U;
+	}
+
+	host_event_wait(timeout);
+}
+
 static void pause(int secs)
 {
 	if(secs == 0) {
@@ -199,6 +221,7 @@ int main(int argc, char* argv[])
 		hostmsg("Initialise-only requested");
 	} else {
 		host_init_tasks();
+		host_event_init();
 
 		sockets_initialise();
 		CUartServer::startup(config.uart);
@@ -221,6 +244,9 @@ int main(int argc, char* argv[])
 			host_service_timers();
 			host_lwip_service();
 			system_soft_wdt_feed();
+			if(!done) {
+				wait_for_events();
+			}
 		}
 
 		hostmsg(">> Normal Exit <<\n");
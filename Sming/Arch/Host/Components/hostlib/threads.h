@@ -22,6 +22,7 @@
 #include "hostlib.h"
 #include <pthread.h>
 #include <semaphore.h>
+#include <time.h>
 
 class CThread
 {
@@ -120,11 +121,17 @@ public:
 		return sem_timedwait(&m_sem, abs_timeout) == 0;
 	}
 
+	// sem_timedwait() requires an absolute time, not an interval
 	bool timedwait(unsigned ms)
 	{
 		timespec to;
-		to.tv_sec = ms / 1000;
-		to.tv_nsec = (ms % 1000) * 1000000;
+		clock_gettime(CLOCK_REALTIME, &to);
+		to.tv_sec += ms / 1000;
+		to.tv_nsec += (ms % 1000) * 1000000;
+		if(to.tv_nsec >= 1000000000) {
+			to.tv_sec += 1;
+			to.tv_nsec -= 1000000000;
+		}
 		return timedwait(&to);
 	}
 
@@ -19,6 +19,7 @@
 
 #include "../host_lwip.h"
 #include "../../hostlib/hostmsg.h"
+#include "../../hostlib/eventloop.h"
 
 #include <lwip/init.h>
 #include <lwip/ip_addr.h>
@@ -32,6 +33,7 @@
 #include <net/if.h>
 #include <netinet/in.h>
 #include <sys/ioctl.h>
+#include <poll.h>
 
 #include <netif/etharp.h>
 #include <netif/tapif.h>
@@ -44,6 +46,7 @@ struct net_config {
 };
 
 static struct netif netif;
+static int tap_fd = -1;
 
 static void getMacAddress(const char* ifname, uint8_t hwaddr[6])
 {
@@ -153,16 +156,39 @@ bool host_lwip_init(const struct lwip_param* param)
 
 	netif_set_default(&netif);
 
+	// The tapif structure is private, but its first (only) member is the file descriptor
+	tap_fd = *(int*)netif.state;
+	host_event_add_fd(tap_fd);
+
 	return true;
 }
 
 void host_lwip_service(void)
 {
-	/* poll netif, pass packet to lwIP */
-	tapif_select(&netif);
+	if(tap_fd < 0) {
+		return;
+	}
+
+	/*
+	 * tapif_select() blocks until a packet arrives or an LWIP timeout is due,
+	 * so only call it when we know there's something to read.
+	 */
+	struct pollfd pfd = {tap_fd, POLLIN, 0};
+	if(poll(&pfd, 1, 0) > 0) {
+		tapif_select(&netif);
+	}
 	sys_check_timeouts();
 }
 
+uint32_t host_lwip_sleeptime(void)
+{
+	return (tap_fd < 0) ? UINT32_MAX : sys_timeouts_sleeptime();
+}
+
 void host_lwip_shutdown(void)
 {
+	if(tap_fd >= 0) {
+		host_event_remove_fd(tap_fd);
+		tap_fd = -1;
+	}
 }
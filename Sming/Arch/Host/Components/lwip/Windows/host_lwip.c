@@ -41,6 +41,7 @@ struct net_config {
 };
 
 static struct netif netif;
+static bool initialised;
 
 /*
  * Find an IP4 address in a list of addresses
@@ -209,18 +210,40 @@ bool host_lwip_init(const struct lwip_param* param)
 	hostmsg("MAC: %02x:%02x:%02x:%02x:%02x:%02x", netif.hwaddr[0], netif.hwaddr[1], netif.hwaddr[2], netif.hwaddr[3],
 			netif.hwaddr[4], netif.hwaddr[5]);
 
+	initialised = true;
 	return true;
 }
 
 void host_lwip_service(void)
 {
+	if(!initialised) {
+		return;
+	}
+
 	/* check for packets and link status*/
 	pcapif_poll(&netif);
 	sys_check_timeouts();
 }
 
+uint32_t host_lwip_sleeptime(void)
+{
+	if(!initialised) {
+		return UINT32_MAX;
+	}
+
+	// There's no waitable handle for pcap so we must poll
+	const uint32_t PCAP_POLL_INTERVAL_MS = 1;
+	uint32_t sleeptime = sys_timeouts_sleeptime();
+	return (sleeptime < PCAP_POLL_INTERVAL_MS) ? sleeptime : PCAP_POLL_INTERVAL_MS;
+}
+
 void host_lwip_shutdown(void)
 {
+	if(!initialised) {
+		return;
+	}
+	initialised = false;
+
 	/* release the pcap library... */
 	pcapif_shutdown(&netif);
 }
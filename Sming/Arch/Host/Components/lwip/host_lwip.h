@@ -35,6 +35,13 @@ struct lwip_param {
 
 bool host_lwip_init(const struct lwip_param* param);
 void host_lwip_service(void);
+
+/**
+ * @brief Get maximum time the main loop may sleep before LWIP requires servicing
+ * @retval uint32_t Time in milliseconds, UINT32_MAX if there's nothing to wait for
+ * @note Incoming packets will also wake the main loop if the interface supports it
+ */
+uint32_t host_lwip_sleeptime(void);
 void host_lwip_shutdown(void);
 
 #ifdef __cplusplus
@@ -0,0 +1,267 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DeltaPatch.cpp
+ *
+ ****/
+
+#include "DeltaPatch.h"
+#include "Platform/WDT.h"
+#include <user_config.h>
+#include <string.h>
+#include <algorithm>
+
+/*
+ * Patch format, see Sming/Arch/Esp8266/Tools/rboot-delta.py
+ */
+#define DELTA_MAGIC 0x544C4453 // "SDLT"
+#define DELTA_OP_SHIFT 5
+#define DELTA_ARG_MASK 0x1f
+
+/*
+ * Arguments of DELTA_ARG_MASK or more are followed by a varint. The generator splits records so
+ * the varint never needs more than this many bytes, which keeps arguments within 28 bits.
+ */
+#define DELTA_MAX_VARINT_BYTES 4
+
+// Header field offsets
+#define DELTA_HDR_MAGIC 0
+#define DELTA_HDR_SOURCE_SIZE 4
+#define DELTA_HDR_TARGET_SIZE 8
+#define DELTA_HDR_SOURCE_HASH 12
+#define DELTA_HDR_TARGET_HASH (DELTA_HDR_SOURCE_HASH + SHA256_SIZE)
+
+enum DeltaOpcode {
+	DELTA_OP_END,
+	DELTA_OP_COPY,
+	DELTA_OP_ADD,
+	DELTA_OP_INSERT,
+	DELTA_OP_SEEK,
+};
+
+static uint32_t getLE32(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+void DeltaPatch::reset()
+{
+	state = eDS_Header;
+	headerLength = 0;
+	sourceSize = 0;
+	targetSize = 0;
+	sourcePos = 0;
+	targetPos = 0;
+	targetHash.reset();
+}
+
+bool DeltaPatch::write(const uint8_t* data, size_t size)
+{
+	const uint8_t* end = data + size;
+	while(data < end && state != eDS_Error) {
+		switch(state) {
+		case eDS_Header: {
+			size_t n = std::min(size_t(end - data), sizeof(header) - headerLength);
+			memcpy(&header[headerLength], data, n);
+			headerLength += n;
+			data += n;
+			if(headerLength == sizeof(header)) {
+				state = (checkHeader() && checkSource()) ? eDS_Opcode : eDS_Error;
+			}
+			break;
+		}
+
+		case eDS_Opcode:
+			opcode = *data >> DELTA_OP_SHIFT;
+			argument = *data & DELTA_ARG_MASK;
+			++data;
+			if(argument == DELTA_ARG_MASK) {
+				argumentBytes = 0;
+				state = eDS_Argument;
+			} else if(!runOpcode()) {
+				state = eDS_Error;
+			}
+			break;
+
+		case eDS_Argument: {
+			if(argumentBytes == DELTA_MAX_VARINT_BYTES) {
+				debug_e("DeltaPatch: Argument too long");
+				state = eDS_Error;
+				break;
+			}
+			uint8_t c = *data++;
+			argument += uint32_t(c & 0x7f) << (7 * argumentBytes);
+			++argumentBytes;
+			if((c & 0x80) == 0 && !runOpcode()) {
+				state = eDS_Error;
+			}
+			break;
+		}
+
+		case eDS_Data: {
+			size_t n = std::min(size_t(end - data), size_t(argument));
+			bool ok = (opcode == DELTA_OP_ADD) ? addSource(data, n) : output(data, n);
+			data += n;
+			argument -= n;
+			if(!ok) {
+				state = eDS_Error;
+			} else if(argument == 0) {
+				state = eDS_Opcode;
+			}
+			break;
+		}
+
+		case eDS_Done:
+		default:
+			debug_e("DeltaPatch: Unexpected data after end of patch");
+			state = eDS_Error;
+		}
+	}
+
+	return state != eDS_Error;
+}
+
+bool DeltaPatch::checkHeader()
+{
+	if(getLE32(&header[DELTA_HDR_MAGIC]) != DELTA_MAGIC) {
+		debug_e("DeltaPatch: Not a delta patch");
+		return false;
+	}
+
+	sourceSize = getLE32(&header[DELTA_HDR_SOURCE_SIZE]);
+	targetSize = getLE32(&header[DELTA_HDR_TARGET_SIZE]);
+	debug_d("DeltaPatch: %u -> %u bytes", sourceSize, targetSize);
+	return true;
+}
+
+bool DeltaPatch::checkSource()
+{
+	Sha256 sourceHash;
+	uint32_t buffer[DELTA_BLOCK_SIZE / 4];
+	for(uint32_t pos = 0; pos < sourceSize; pos += sizeof(buffer)) {
+		size_t n = std::min(size_t(sourceSize - pos), sizeof(buffer));
+		if(!readSource(pos, reinterpret_cast<uint8_t*>(buffer), n)) {
+			return false;
+		}
+		sourceHash.update(buffer, n);
+		WDT.alive();
+	}
+
+	uint8_t hash[SHA256_SIZE];
+	sourceHash.getHash(hash);
+	if(memcmp(hash, &header[DELTA_HDR_SOURCE_HASH], SHA256_SIZE) != 0) {
+		debug_e("DeltaPatch: Patch was not made from this source image");
+		return false;
+	}
+
+	return true;
+}
+
+bool DeltaPatch::runOpcode()
+{
+	state = eDS_Opcode;
+
+	switch(opcode) {
+	case DELTA_OP_END: {
+		uint8_t hash[SHA256_SIZE];
+		targetHash.getHash(hash);
+		if(targetPos != targetSize || memcmp(hash, &header[DELTA_HDR_TARGET_HASH], SHA256_SIZE) != 0) {
+			debug_e("DeltaPatch: Patched image is corrupt");
+			return false;
+		}
+		debug_d("DeltaPatch: Patched %u bytes", targetPos);
+		state = eDS_Done;
+		return true;
+	}
+
+	case DELTA_OP_COPY:
+		return copySource(argument);
+
+	case DELTA_OP_ADD:
+	case DELTA_OP_INSERT:
+		if(argument != 0) {
+			state = eDS_Data;
+		}
+		return true;
+
+	case DELTA_OP_SEEK: {
+		// Zigzag encoded
+		int32_t offset = (argument & 1) ? -int32_t((argument + 1) >> 1) : int32_t(argument >> 1);
+		sourcePos += offset;
+		return true;
+	}
+
+	default:
+		debug_e("DeltaPatch: Bad opcode %u", opcode);
+		return false;
+	}
+}
+
+bool DeltaPatch::copySource(uint32_t length)
+{
+	if(sourcePos > sourceSize || length > sourceSize - sourcePos) {
+		debug_e("DeltaPatch: Copy outside source image");
+		return false;
+	}
+
+	uint32_t buffer[DELTA_BLOCK_SIZE / 4];
+	auto bytes = reinterpret_cast<uint8_t*>(buffer);
+	while(length != 0) {
+		size_t n = std::min(size_t(length), sizeof(buffer));
+		if(!readSource(sourcePos, bytes, n) || !output(bytes, n)) {
+			return false;
+		}
+		sourcePos += n;
+		length -= n;
+		WDT.alive();
+	}
+
+	return true;
+}
+
+bool DeltaPatch::addSource(const uint8_t* data, size_t length)
+{
+	if(sourcePos > sourceSize || length > sourceSize - sourcePos) {
+		debug_e("DeltaPatch: Add outside source image");
+		return false;
+	}
+
+	uint32_t buffer[DELTA_BLOCK_SIZE / 4];
+	auto bytes = reinterpret_cast<uint8_t*>(buffer);
+	while(length != 0) {
+		size_t n = std::min(length, sizeof(buffer));
+		if(!readSource(sourcePos, bytes, n)) {
+			return false;
+		}
+		for(size_t i = 0; i < n; ++i) {
+			bytes[i] += data[i];
+		}
+		if(!output(bytes, n)) {
+			return false;
+		}
+		data += n;
+		sourcePos += n;
+		length -= n;
+	}
+
+	return true;
+}
+
+bool DeltaPatch::output(const uint8_t* data, size_t length)
+{
+	if(length > targetSize - targetPos) {
+		debug_e("DeltaPatch: Patched image too large");
+		return false;
+	}
+
+	if(!writeTarget(data, length)) {
+		return false;
+	}
+
+	targetHash.update(data, length);
+	targetPos += length;
+	return true;
+}
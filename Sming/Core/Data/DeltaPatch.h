@@ -0,0 +1,116 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * DeltaPatch.h
+ *
+ ****/
+
+#pragma once
+
+#include "Sha256.h"
+
+/// Source data is read in blocks of this size
+#define DELTA_BLOCK_SIZE 256
+
+/// Patch header: magic, source size, target size, source hash, target hash
+#define DELTA_HEADER_SIZE (12 + SHA256_SIZE * 2)
+
+/** @brief Applies a delta patch created by Sming/Arch/Esp8266/Tools/rboot-delta.py
+ *
+ *  Patch data may be written in pieces of any size as it arrives. The source image is read, and the
+ *  patched image written, through virtual methods so decoding doesn't depend on where the images
+ *  are kept. The source is checked against the hash in the patch before anything is written, and
+ *  the patched image is checked against its hash when the patch is complete.
+ */
+class DeltaPatch
+{
+public:
+	virtual ~DeltaPatch()
+	{
+	}
+
+	/** @brief Decode the next part of the patch
+	 *  @param data
+	 *  @param size
+	 *  @retval bool false if the patch is invalid, or the source or target could not be accessed
+	 */
+	bool write(const uint8_t* data, size_t size);
+
+	/** @brief Start decoding a new patch
+	 */
+	void reset();
+
+	/** @brief Determine if the complete patch has been applied and the result verified
+	 */
+	bool isFinished() const
+	{
+		return state == eDS_Done;
+	}
+
+	bool isError() const
+	{
+		return state == eDS_Error;
+	}
+
+	/** @brief Size of the source image, once the patch header has been read
+	 */
+	uint32_t getSourceSize() const
+	{
+		return sourceSize;
+	}
+
+	/** @brief Size of the patched image, once the patch header has been read
+	 */
+	uint32_t getTargetSize() const
+	{
+		return targetSize;
+	}
+
+protected:
+	/** @brief Read part of the source image
+	 *  @param offset From start of source
+	 *  @param buffer Word-aligned
+	 *  @param length Never more than DELTA_BLOCK_SIZE
+	 *  @retval bool
+	 */
+	virtual bool readSource(uint32_t offset, uint8_t* buffer, size_t length) = 0;
+
+	/** @brief Write the next part of the patched image
+	 *  @param data
+	 *  @param length
+	 *  @retval bool
+	 */
+	virtual bool writeTarget(const uint8_t* data, size_t length) = 0;
+
+private:
+	enum State {
+		eDS_Header,
+		eDS_Opcode,
+		eDS_Argument, ///< Reading varint
+		eDS_Data,	 ///< Reading ADD or INSERT data
+		eDS_Done,
+		eDS_Error,
+	};
+
+	bool checkHeader();
+	bool checkSource();
+	bool runOpcode();
+	bool copySource(uint32_t length);
+	bool addSource(const uint8_t* data, size_t length);
+	bool output(const uint8_t* data, size_t length);
+
+	State state = eDS_Header;
+	uint8_t header[DELTA_HEADER_SIZE];
+	unsigned headerLength = 0;
+	uint32_t sourceSize = 0;
+	uint32_t targetSize = 0;
+	uint8_t opcode = 0;
+	uint32_t argument = 0;
+	uint8_t argumentBytes = 0;
+	uint32_t sourcePos = 0;
+	uint32_t targetPos = 0;
+	Sha256 targetHash;
+};
@@ -0,0 +1,81 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MemoryPool.cpp
+ *
+ ****/
+
+#include "MemoryPool.h"
+#include <user_config.h>
+
+bool MemoryPool::initialise(size_t blockSize, unsigned blockCount)
+{
+	if(used() != 0) {
+		debug_w("MemoryPool: %u blocks in use, cannot resize", used());
+		return false;
+	}
+
+	delete[] storage;
+	storage = nullptr;
+	freeList = nullptr;
+	this->blockCount = 0;
+	freeCount = 0;
+
+	// Storage from new[] is aligned for any type, so keep every block aligned the same way
+	const size_t alignment = alignof(max_align_t);
+	blockSize = (blockSize + alignment - 1) & ~(alignment - 1);
+	if(blockSize < sizeof(FreeBlock)) {
+		blockSize = sizeof(FreeBlock);
+	}
+	this->blockSize = blockSize;
+
+	if(blockCount == 0) {
+		return true;
+	}
+
+	storage = new uint8_t[blockSize * blockCount];
+	if(storage == nullptr) {
+		debug_e("MemoryPool: Failed to allocate %u x %u bytes", blockCount, unsigned(blockSize));
+		return false;
+	}
+
+	// Build free list in address order
+	for(unsigned i = blockCount; i != 0; --i) {
+		auto block = reinterpret_cast<FreeBlock*>(storage + (i - 1) * blockSize);
+		block->next = freeList;
+		freeList = block;
+	}
+	this->blockCount = blockCount;
+	freeCount = blockCount;
+
+	return true;
+}
+
+void* MemoryPool::allocate(size_t size)
+{
+	if(size > blockSize || freeList == nullptr) {
+		++missCount;
+		return nullptr;
+	}
+
+	auto block = freeList;
+	freeList = block->next;
+	--freeCount;
+	return block;
+}
+
+bool MemoryPool::release(void* block)
+{
+	if(block == nullptr || !contains(block)) {
+		return false;
+	}
+
+	auto fb = static_cast<FreeBlock*>(block);
+	fb->next = freeList;
+	freeList = fb;
+	++freeCount;
+	return true;
+}
@@ -0,0 +1,110 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * MemoryPool.h
+ *
+ ****/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Allocator for a fixed number of equally-sized blocks
+ *  @note All blocks are taken from a single heap allocation made when the pool is created,
+ *  so objects which are repeatedly created and destroyed (such as server connections) do not
+ *  fragment the heap. The pool is intended for use by class-specific `operator new` and `operator delete`.
+ *
+ *  	class MyConnection {
+ *  	public:
+ *  		static void* operator new(size_t size)
+ *  		{
+ *  			return pool.allocate(size) ?: ::operator new(size);
+ *  		}
+ *
+ *  		static void operator delete(void* ptr)
+ *  		{
+ *  			if(!pool.release(ptr)) {
+ *  				::operator delete(ptr);
+ *  			}
+ *  		}
+ *  		...
+ *  	};
+ */
+class MemoryPool
+{
+public:
+	~MemoryPool()
+	{
+		delete[] storage;
+	}
+
+	/** @brief Allocate storage for the pool
+	 *  @param blockSize Size of each block, will be rounded up to a multiple of `alignof(max_align_t)`
+	 *  so blocks are suitably aligned for any type, as with `operator new`
+	 *  @param blockCount Number of blocks
+	 *  @retval bool false if pool already in use or memory allocation failed
+	 *  @note An existing pool may be resized only if no blocks are in use
+	 */
+	bool initialise(size_t blockSize, unsigned blockCount);
+
+	/** @brief Get a free block
+	 *  @param size Required size, must not exceed the pool block size
+	 *  @retval void* nullptr if the pool has no free blocks or size is too large
+	 */
+	void* allocate(size_t size);
+
+	/** @brief Return a block to the pool
+	 *  @param block
+	 *  @retval bool false if block was not obtained from this pool
+	 */
+	bool release(void* block);
+
+	/** @brief Determine if a block is from this pool */
+	bool contains(const void* block) const
+	{
+		auto p = static_cast<const uint8_t*>(block);
+		return p >= storage && p < storage + (blockSize * blockCount);
+	}
+
+	size_t getBlockSize() const
+	{
+		return blockSize;
+	}
+
+	unsigned capacity() const
+	{
+		return blockCount;
+	}
+
+	unsigned available() const
+	{
+		return freeCount;
+	}
+
+	unsigned used() const
+	{
+		return blockCount - freeCount;
+	}
+
+	/** @brief Number of allocation requests which could not be met by the pool */
+	unsigned getMissCount() const
+	{
+		return missCount;
+	}
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	uint8_t* storage = nullptr;
+	FreeBlock* freeList = nullptr;
+	size_t blockSize = 0;
+	unsigned blockCount = 0;
+	unsigned freeCount = 0;
+	unsigned missCount = 0;
+};
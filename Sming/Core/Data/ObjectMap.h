@@ -213,6 +213,7 @@ public:
 			entries[i].value = value;
 		} else {
 			entries.addElement(new Entry(key, value));
+			++generation;
 		}
 	}
 
@@ -260,6 +261,7 @@ public:
 	void removeAt(unsigned index)
 	{
 		entries.remove(index);
+		++generation;
 	}
 
 	/**
@@ -303,6 +305,7 @@ public:
 			value = entries[index].value;
 			entries[index].value = nullptr;
 			entries.remove(index);
+			++generation;
 		}
 		return value;
 	}
@@ -313,6 +316,7 @@ public:
 	void clear()
 	{
 		entries.clear();
+		++generation;
 	}
 
 protected:
@@ -334,6 +338,7 @@ protected:
 	};
 
 	Vector<Entry> entries;
+	unsigned generation = 0; ///< Changes whenever entries are added or removed, so indices may have moved
 
 private:
 	// Copy constructor unsafe, so prevent access
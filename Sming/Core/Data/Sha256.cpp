@@ -0,0 +1,146 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Sha256.cpp
+ *
+ * Implementation follows FIPS 180-4.
+ *
+ ****/
+
+#include "Sha256.h"
+#include <string.h>
+
+static const uint32_t roundConstants[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static inline uint32_t ror(uint32_t x, unsigned n)
+{
+	return (x >> n) | (x << (32 - n));
+}
+
+void Sha256::reset()
+{
+	static const uint32_t initialState[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+	};
+	memcpy(state, initialState, sizeof(state));
+	count = 0;
+}
+
+void Sha256::transform(uint32_t state[8], const uint8_t block[64])
+{
+	uint32_t w[64];
+	for(unsigned i = 0; i < 16; ++i) {
+		w[i] = (uint32_t(block[i * 4]) << 24) | (uint32_t(block[i * 4 + 1]) << 16) |
+			   (uint32_t(block[i * 4 + 2]) << 8) | block[i * 4 + 3];
+	}
+	for(unsigned i = 16; i < 64; ++i) {
+		uint32_t s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = state[0];
+	uint32_t b = state[1];
+	uint32_t c = state[2];
+	uint32_t d = state[3];
+	uint32_t e = state[4];
+	uint32_t f = state[5];
+	uint32_t g = state[6];
+	uint32_t h = state[7];
+
+	for(unsigned i = 0; i < 64; ++i) {
+		uint32_t s1 = ror(e, 6) ^ ror(e, 11) ^ ror(e, 25);
+		uint32_t ch = (e & f) ^ (~e & g);
+		uint32_t t1 = h + s1 + ch + roundConstants[i] + w[i];
+		uint32_t s0 = ror(a, 2) ^ ror(a, 13) ^ ror(a, 22);
+		uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+		uint32_t t2 = s0 + maj;
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	state[0] += a;
+	state[1] += b;
+	state[2] += c;
+	state[3] += d;
+	state[4] += e;
+	state[5] += f;
+	state[6] += g;
+	state[7] += h;
+}
+
+void Sha256::update(const void* data, size_t length)
+{
+	auto p = static_cast<const uint8_t*>(data);
+	unsigned used = count % sizeof(buffer);
+	count += length;
+
+	// Complete any partial block first
+	if(used != 0) {
+		size_t n = sizeof(buffer) - used;
+		if(length < n) {
+			memcpy(&buffer[used], p, length);
+			return;
+		}
+		memcpy(&buffer[used], p, n);
+		transform(state, buffer);
+		p += n;
+		length -= n;
+	}
+
+	// Process whole blocks directly from the source
+	while(length >= sizeof(buffer)) {
+		transform(state, p);
+		p += sizeof(buffer);
+		length -= sizeof(buffer);
+	}
+
+	memcpy(buffer, p, length);
+}
+
+void Sha256::getHash(uint8_t hash[SHA256_SIZE]) const
+{
+	// Pad a copy, so more data may still be added afterwards
+	uint32_t finalState[8];
+	memcpy(finalState, state, sizeof(finalState));
+	uint8_t block[sizeof(buffer)];
+	unsigned used = count % sizeof(buffer);
+	memcpy(block, buffer, used);
+	block[used++] = 0x80;
+	if(used > sizeof(block) - 8) {
+		memset(&block[used], 0, sizeof(block) - used);
+		transform(finalState, block);
+		used = 0;
+	}
+	memset(&block[used], 0, sizeof(block) - 8 - used);
+	uint64_t bits = count * 8;
+	for(unsigned i = 0; i < 8; ++i) {
+		block[sizeof(block) - 1 - i] = uint8_t(bits >> (i * 8));
+	}
+	transform(finalState, block);
+
+	for(unsigned i = 0; i < 8; ++i) {
+		hash[i * 4] = finalState[i] >> 24;
+		hash[i * 4 + 1] = finalState[i] >> 16;
+		hash[i * 4 + 2] = finalState[i] >> 8;
+		hash[i * 4 + 3] = finalState[i];
+	}
+}
@@ -0,0 +1,53 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * Sha256.h
+ *
+ ****/
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SHA256_SIZE 32
+
+/** @brief Incremental SHA-256 hash
+ *
+ *  Data may be added in pieces of any size as it arrives, so large items such as firmware images
+ *  can be verified without holding them in memory. Does not depend on the SSL library.
+ */
+class Sha256
+{
+public:
+	Sha256()
+	{
+		reset();
+	}
+
+	/** @brief Start a new hash
+	 */
+	void reset();
+
+	/** @brief Add data to the hash
+	 *  @param data
+	 *  @param length
+	 */
+	void update(const void* data, size_t length);
+
+	/** @brief Obtain the hash of all data added since the last reset
+	 *  @param hash Receives the result
+	 *  @note The hash may be updated further afterwards
+	 */
+	void getHash(uint8_t hash[SHA256_SIZE]) const;
+
+private:
+	static void transform(uint32_t state[8], const uint8_t block[64]);
+
+	uint32_t state[8];
+	uint64_t count; ///< Total bytes added
+	uint8_t buffer[64];
+};
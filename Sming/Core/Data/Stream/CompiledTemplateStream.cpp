@@ -0,0 +1,240 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.cpp
+ *
+ ****/
+
+#include "CompiledTemplateStream.h"
+
+/*
+ * Compiled template layout, see Tools/compile-template.py. Tables are word-aligned in flash
+ * so are read using memcpy_P.
+ */
+#define TEMPLATE_MAGIC 0x4C504D54 // "TMPL"
+#define TEMPLATE_LITERAL_SEGMENT 0xFFFF
+
+struct CompiledTemplateHeader {
+	uint32_t magic;
+	uint16_t varCount;
+	uint16_t segmentCount;
+};
+
+// 32-bit FNV-1a, must match the template compiler
+static uint32_t hashName(const char* name, size_t length)
+{
+	uint32_t hash = 0x811C9DC5;
+	for(size_t i = 0; i < length; ++i) {
+		hash = (hash ^ uint8_t(name[i])) * 0x01000193;
+	}
+	return hash;
+}
+
+CompiledTemplateStream::CompiledTemplateStream(const FlashString& compiled) : compiled(compiled)
+{
+	CompiledTemplateHeader header;
+	if(compiled.length() < sizeof(header)) {
+		debug_e("CompiledTemplateStream: Invalid template");
+		return;
+	}
+
+	memcpy_P(&header, compiled.flashData, sizeof(header));
+	size_t tableSize = sizeof(header) + (header.varCount * sizeof(VarEntry)) + (header.segmentCount * sizeof(Segment));
+	if(header.magic != TEMPLATE_MAGIC || compiled.length() < tableSize) {
+		debug_e("CompiledTemplateStream: Invalid template");
+		return;
+	}
+
+	if(header.varCount != 0) {
+		values = new String[header.varCount];
+		if(values == nullptr) {
+			return;
+		}
+	}
+
+	varCount = header.varCount;
+	segmentCount = header.segmentCount;
+	valid = true;
+}
+
+void CompiledTemplateStream::getVarEntry(unsigned index, VarEntry& entry) const
+{
+	auto offset = sizeof(CompiledTemplateHeader) + (index * sizeof(VarEntry));
+	memcpy_P(&entry, &compiled.flashData[offset], sizeof(entry));
+}
+
+void CompiledTemplateStream::getSegment(unsigned index, Segment& segment) const
+{
+	auto offset = sizeof(CompiledTemplateHeader) + (varCount * sizeof(VarEntry)) + (index * sizeof(Segment));
+	memcpy_P(&segment, &compiled.flashData[offset], sizeof(segment));
+}
+
+size_t CompiledTemplateStream::getSegmentData(const Segment& segment, const char*& data, bool& isFlash) const
+{
+	if(segment.varIndex == TEMPLATE_LITERAL_SEGMENT) {
+		data = &compiled.flashData[segment.offset];
+		isFlash = true;
+		return segment.length;
+	}
+
+	const String& value = values[segment.varIndex];
+	if(value) {
+		data = value.c_str();
+		isFlash = false;
+		return value.length();
+	}
+
+	// Not set, so output the original text including braces
+	VarEntry entry;
+	getVarEntry(segment.varIndex, entry);
+	data = &compiled.flashData[entry.nameOffset - 1];
+	isFlash = true;
+	return entry.nameLength + 2;
+}
+
+int CompiledTemplateStream::findVar(const String& name) const
+{
+	uint32_t hash = hashName(name.c_str(), name.length());
+
+	// Binary search for the first entry with a matching hash
+	unsigned low = 0;
+	unsigned high = varCount;
+	VarEntry entry;
+	while(low < high) {
+		unsigned mid = (low + high) / 2;
+		getVarEntry(mid, entry);
+		if(entry.hash < hash) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+
+	// Collisions are possible, so check each entry with this hash
+	for(unsigned i = low; i < varCount; ++i) {
+		getVarEntry(i, entry);
+		if(entry.hash != hash) {
+			break;
+		}
+		if(entry.nameLength == name.length() &&
+		   strncmp_P(name.c_str(), &compiled.flashData[entry.nameOffset], entry.nameLength) == 0) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+bool CompiledTemplateStream::setVar(const String& name, const String& value)
+{
+	int i = findVar(name);
+	if(i < 0) {
+		debug_d("CompiledTemplateStream: '%s' not used", name.c_str());
+		return false;
+	}
+
+	values[i] = value;
+	return true;
+}
+
+void CompiledTemplateStream::setVars(const TemplateVariables& vars)
+{
+	for(unsigned i = 0; i < vars.count(); ++i) {
+		setVar(vars.keyAt(i), vars.valueAt(i));
+	}
+}
+
+String CompiledTemplateStream::getVarName(unsigned index) const
+{
+	if(index >= varCount) {
+		return nullptr;
+	}
+
+	VarEntry entry;
+	getVarEntry(index, entry);
+	return String(FPSTR(&compiled.flashData[entry.nameOffset]), entry.nameLength);
+}
+
+int CompiledTemplateStream::available()
+{
+	size_t total = 0;
+	Segment segment;
+	const char* data;
+	bool isFlash;
+	for(unsigned i = segmentIndex; i < segmentCount; ++i) {
+		getSegment(i, segment);
+		total += getSegmentData(segment, data, isFlash);
+	}
+
+	return total - segmentPos;
+}
+
+uint16_t CompiledTemplateStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(data == nullptr || bufSize <= 0) {
+		return 0;
+	}
+
+	// Fill the buffer from as many segments as will fit
+	bufSize = std::min(bufSize, 0xFFFF);
+	size_t count = 0;
+	size_t pos = segmentPos;
+	for(unsigned i = segmentIndex; i < segmentCount && count < size_t(bufSize); ++i) {
+		Segment segment;
+		getSegment(i, segment);
+		const char* segmentData;
+		bool isFlash;
+		size_t length = getSegmentData(segment, segmentData, isFlash);
+		if(pos >= length) {
+			pos = 0;
+			continue;
+		}
+
+		size_t n = std::min(length - pos, bufSize - count);
+		if(isFlash) {
+			memcpy_P(&data[count], &segmentData[pos], n);
+		} else {
+			memcpy(&data[count], &segmentData[pos], n);
+		}
+		count += n;
+		pos = 0;
+	}
+
+	if(count == 0) {
+		// Only empty values remain
+		segmentIndex = segmentCount;
+		segmentPos = 0;
+	}
+
+	return count;
+}
+
+bool CompiledTemplateStream::seek(int len)
+{
+	// Forward-only seeks
+	if(len < 0) {
+		return false;
+	}
+
+	size_t remain = len;
+	while(segmentIndex < segmentCount) {
+		Segment segment;
+		getSegment(segmentIndex, segment);
+		const char* data;
+		bool isFlash;
+		size_t length = getSegmentData(segment, data, isFlash);
+		if(segmentPos + remain < length) {
+			segmentPos += remain;
+			return true;
+		}
+
+		remain -= length - segmentPos;
+		segmentPos = 0;
+		++segmentIndex;
+	}
+
+	return remain == 0;
+}
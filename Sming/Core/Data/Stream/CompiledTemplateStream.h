@@ -0,0 +1,137 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * CompiledTemplateStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "DataSourceStream.h"
+#include "TemplateStream.h"
+#include "FlashString.h"
+
+/** @addtogroup stream
+ *  @{
+ */
+
+/*
+ * CompiledTemplateStream
+ *
+ * Renders a template pre-processed by `Tools/compile-template.py`, typically bound into flash using IMPORT_FSTR.
+ * The template is already split into literal and variable segments, so output is a straight walk through the
+ * segment table without any scanning. Variables are located by hash when set, and values of any length are
+ * streamed in pieces as the reader requires.
+ *
+ * Variables which haven't been set are output unchanged, as for TemplateStream.
+ *
+ * To build compiled templates, list the source files in TEMPLATE_FILES in the project Makefile-user.mk:
+ *
+ * 		TEMPLATE_FILES = web/index.html
+ *
+ * then import the result:
+ *
+ * 		IMPORT_FSTR(indexTemplate, "out/templates/index.html.bin")
+ * 		...
+ * 		auto tmpl = new CompiledTemplateStream(indexTemplate);
+ * 		tmpl->setVar("name", "value");
+ */
+class CompiledTemplateStream : public IDataSourceStream
+{
+public:
+	/** @brief Create a stream on a compiled template
+	 *  @param compiled Output from the template compiler
+	 */
+	CompiledTemplateStream(const FlashString& compiled);
+
+	~CompiledTemplateStream()
+	{
+		delete[] values;
+	}
+
+	StreamType getStreamType() const override
+	{
+		return valid ? eSST_Template : eSST_Invalid;
+	}
+
+	/**
+	 * @brief Return the number of bytes remaining
+	 * @retval int Content length is known, so unlike TemplateStream this never returns -1
+	 */
+	int available() override;
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override
+	{
+		return segmentIndex >= segmentCount;
+	}
+
+	/** @brief Find a variable in the template
+	 *  @param name
+	 *  @retval int Index of variable, -1 if not found
+	 */
+	int findVar(const String& name) const;
+
+	/** @brief Set value of a variable in the template
+	 *  @param name Name of variable
+	 *  @param value Value to assign to the variable
+	 *  @retval bool false if the template does not contain the variable
+	 *  @note Values should not be changed once reading has started
+	 */
+	bool setVar(const String& name, const String& value);
+
+	/** @brief Set multiple variables in the template
+	 *  @param vars Template Variables; any not used by the template are ignored
+	 */
+	void setVars(const TemplateVariables& vars);
+
+	/** @brief Get the number of distinct variables used in the template
+	 */
+	unsigned getVarCount() const
+	{
+		return varCount;
+	}
+
+	/** @brief Get the name of a template variable
+	 *  @param index
+	 *  @retval String Invalid if index is out of range
+	 */
+	String getVarName(unsigned index) const;
+
+private:
+	struct VarEntry {
+		uint32_t hash;
+		uint16_t nameOffset;
+		uint16_t nameLength;
+	};
+
+	struct Segment {
+		uint32_t offset;
+		uint16_t length;
+		uint16_t varIndex;
+	};
+
+	void getVarEntry(unsigned index, VarEntry& entry) const;
+	void getSegment(unsigned index, Segment& segment) const;
+
+	/** @brief Resolve a segment to its content
+	 *  @retval size_t Length of segment content
+	 */
+	size_t getSegmentData(const Segment& segment, const char*& data, bool& isFlash) const;
+
+	const FlashString& compiled;
+	String* values = nullptr;
+	uint16_t varCount = 0;
+	uint16_t segmentCount = 0;
+	uint16_t segmentIndex = 0; ///< Current read position
+	size_t segmentPos = 0;
+	bool valid = false;
+};
+
+/** @} */
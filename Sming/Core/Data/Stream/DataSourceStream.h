@@ -64,6 +64,18 @@ public:
      */
 	virtual uint16_t readMemoryBlock(char* data, int bufSize) = 0;
 
+	/** @brief Get direct access to stream data at the current read position
+	 *  @param data On success, points to the data
+	 *  @retval size_t Number of contiguous bytes available, 0 if not supported
+	 *  @note Only streams whose content is held in RAM should implement this. The memory must remain
+	 *  valid and unchanged until the stream is destroyed, as it may be passed directly to the network
+	 *  stack instead of being copied. See `TcpConnection::write(IDataSourceStream*)`.
+	 */
+	virtual size_t getMemoryBlock(const char*& data)
+	{
+		return 0;
+	}
+
 	/**
 	 * @brief Read one character and moves the stream pointer
 	 * @retval The character that was read or -1 if none is available
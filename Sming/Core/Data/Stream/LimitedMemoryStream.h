@@ -49,6 +49,13 @@ public:
 
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	//Use base class documentation
+	size_t getMemoryBlock(const char*& data) override
+	{
+		data = reinterpret_cast<const char*>(buffer) + readPos;
+		return available();
+	}
+
 	//Use base class documentation
 	bool seek(int len) override;
 
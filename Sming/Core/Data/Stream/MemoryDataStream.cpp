@@ -13,6 +13,7 @@
 size_t MemoryDataStream::write(const uint8_t* data, size_t len)
 {
 	//TODO: add queued buffers without full copy
+	size_t readOffset = pos - buf;
 	if(buf == nullptr) {
 		buf = (char*)malloc(len + 1);
 		if(buf == nullptr)
@@ -23,6 +24,10 @@ size_t MemoryDataStream::write(const uint8_t* data, size_t len)
 		int cur = size;
 		int required = cur + len + 1;
 		if(required > capacity) {
+			if(fixed) {
+				debug_e("MemoryDataStream: buffer in use, cannot grow");
+				return 0;
+			}
 			capacity = required < 256 ? required + 128 : required + 64;
 			debug_d("realloc %d -> %d", size, capacity);
 			char* new_buf;
@@ -37,7 +42,8 @@ size_t MemoryDataStream::write(const uint8_t* data, size_t len)
 		buf[cur + len] = '\0';
 		memcpy(buf + cur, data, len);
 	}
-	pos = buf;
+	// Appending data doesn't affect the read position
+	pos = buf + readOffset;
 	size += len;
 	return len;
 }
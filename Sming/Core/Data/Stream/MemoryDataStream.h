@@ -68,6 +68,17 @@ public:
 	//Use base class documentation
 	uint16_t readMemoryBlock(char* data, int bufSize) override;
 
+	/** @brief Get direct access to stream data
+	 *  @note Once called, the buffer is fixed: any subsequent write() which requires
+	 *  more memory will fail.
+	 */
+	size_t getMemoryBlock(const char*& data) override
+	{
+		fixed = true;
+		data = pos;
+		return available();
+	}
+
 	//Use base class documentation
 	bool seek(int len) override;
 
@@ -82,6 +93,7 @@ private:
 	char* pos = nullptr;
 	int size = 0;
 	int capacity = 0;
+	bool fixed = false; ///< Buffer may be referenced externally so cannot be reallocated
 };
 
 /** @} */
@@ -0,0 +1,62 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SharedMemoryStream.cpp
+ *
+ ****/
+
+#include "SharedMemoryStream.h"
+
+SharedMemoryStream::SharedMemoryStream(size_t size)
+{
+	block = static_cast<Block*>(malloc(sizeof(Block) + size));
+	if(block != nullptr) {
+		block->refCount = 1;
+		block->length = size;
+	}
+}
+
+SharedMemoryStream::~SharedMemoryStream()
+{
+	if(block != nullptr && --block->refCount == 0) {
+		free(block);
+	}
+}
+
+bool SharedMemoryStream::setLength(size_t length)
+{
+	if(length > getLength()) {
+		return false;
+	}
+
+	block->length = length;
+	if(readPos > length) {
+		readPos = length;
+	}
+	return true;
+}
+
+uint16_t SharedMemoryStream::readMemoryBlock(char* data, int bufSize)
+{
+	int count = std::min(available(), bufSize);
+	if(count <= 0) {
+		return 0;
+	}
+
+	memcpy(data, getData() + readPos, count);
+	return count;
+}
+
+bool SharedMemoryStream::seek(int len)
+{
+	size_t newPos = readPos + len;
+	if(len < 0 || newPos > getLength()) {
+		return false;
+	}
+
+	readPos = newPos;
+	return true;
+}
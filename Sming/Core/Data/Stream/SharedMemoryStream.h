@@ -0,0 +1,109 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SharedMemoryStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "DataSourceStream.h"
+
+/** @addtogroup stream
+ *  @{
+ */
+
+/*
+ * SharedMemoryStream
+ *
+ * Read-only stream over a reference-counted heap buffer. Copies share the same data but each
+ * has its own read position, so a single block of content can be queued on several connections
+ * at once. The buffer is freed when the last stream referencing it is deleted.
+ *
+ * Memory is stable, so data is passed directly to the TCP stack (see `getMemoryBlock()`).
+ */
+class SharedMemoryStream : public IDataSourceStream
+{
+public:
+	/** @brief Allocate a new buffer
+	 *  @param size Capacity in bytes; fill it via getData() then call setLength() if required
+	 */
+	explicit SharedMemoryStream(size_t size);
+
+	/** @brief Create another reader for the same buffer, starting at the beginning */
+	SharedMemoryStream(const SharedMemoryStream& other) : block(other.block)
+	{
+		if(block != nullptr) {
+			++block->refCount;
+		}
+	}
+
+	~SharedMemoryStream();
+
+	SharedMemoryStream& operator=(const SharedMemoryStream&) = delete;
+
+	StreamType getStreamType() const override
+	{
+		return block ? eSST_Memory : eSST_Invalid;
+	}
+
+	/** @brief Get writeable pointer to the buffer
+	 *  @note Content must not be changed once the stream, or any copy, has been sent
+	 */
+	char* getData()
+	{
+		return block ? reinterpret_cast<char*>(block + 1) : nullptr;
+	}
+
+	/** @brief Get the length of valid data in the buffer */
+	size_t getLength() const
+	{
+		return block ? block->length : 0;
+	}
+
+	/** @brief Reduce the length of valid data, e.g. after encoding into the buffer
+	 *  @retval bool false if length exceeds the current length
+	 */
+	bool setLength(size_t length);
+
+	/** @brief Get the number of streams sharing the buffer */
+	unsigned getRefCount() const
+	{
+		return block ? block->refCount : 0;
+	}
+
+	int available() override
+	{
+		return getLength() - readPos;
+	}
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	size_t getMemoryBlock(const char*& data) override
+	{
+		data = getData() + readPos;
+		return available();
+	}
+
+	bool seek(int len) override;
+
+	bool isFinished() override
+	{
+		return readPos >= getLength();
+	}
+
+private:
+	struct Block {
+		unsigned refCount;
+		size_t length;
+		// Data follows
+	};
+
+	Block* block;
+	size_t readPos = 0;
+};
+
+/** @} */
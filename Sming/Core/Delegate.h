@@ -16,6 +16,10 @@
 #pragma once
 
 #include <user_config.h>
+#include <string.h>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /** @brief  IDelegateCaller class
  *  @todo   Provide more informative brief description of IDelegateCaller
@@ -97,7 +101,7 @@ public:
 	/** @brief  Instantiate a delegate function caller object
      *  @param  m Method declaration
      */
-	FunctionCaller(MethodDeclaration m) : mMethod(m)
+	FunctionCaller(MethodDeclaration m) : mMethod(std::move(m))
 	{
 	}
 
@@ -116,6 +120,23 @@ private:
 
 template <class> class Delegate; /* undefined */
 
+/*
+ * Storage for the common cases of a plain function pointer, or object pointer plus method pointer,
+ * is held within the Delegate itself so construction, copying and invocation require no heap allocation.
+ * Small callables such as lambdas with a few trivially-copyable captures are stored the same way.
+ * Anything larger, or with non-trivial copy/destruction semantics, is allocated as a reference-counted
+ * IDelegateCaller as before.
+ */
+class DelegateUndefinedClass;
+
+#define DELEGATE_STORAGE_SIZE (sizeof(void*) + sizeof(void (DelegateUndefinedClass::*)()))
+
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ < 5
+#define DELEGATE_IS_TRIVIALLY_COPYABLE(T) __has_trivial_copy(T)
+#else
+#define DELEGATE_IS_TRIVIALLY_COPYABLE(T) std::is_trivially_copyable<T>::value
+#endif
+
 /** @brief  Delegate class
 */
 template <class ReturnType, class... ParamsList> class Delegate<ReturnType(ParamsList...)>
@@ -126,6 +147,30 @@ template <class ReturnType, class... ParamsList> class Delegate<ReturnType(Param
 
 	template <typename ClassType> using MethodDeclaration = ReturnType (ClassType::*)(ParamsList...);
 
+	typedef IDelegateCaller<ReturnType, ParamsList...> Caller;
+
+	typedef ReturnType (*Invoker)(const void* storage, ParamsList... params);
+
+	template <class ClassType> struct MethodStorage {
+		ClassType* object;
+		MethodDeclaration<ClassType> method;
+	};
+
+	// Callable objects which can be stored by value
+	template <class Callable> struct IsInline {
+		static constexpr bool value = sizeof(Callable) <= DELEGATE_STORAGE_SIZE &&
+									  alignof(Callable) <= alignof(void*) &&
+									  DELEGATE_IS_TRIVIALLY_COPYABLE(Callable) &&
+									  std::is_trivially_destructible<Callable>::value;
+	};
+
+	// Enable constructor for callable objects, excluding Delegate itself and those which decay to function pointers
+	template <class Callable>
+	using EnableIfCallable = typename std::enable_if<
+		!std::is_same<typename std::decay<Callable>::type, Delegate>::value &&
+			!std::is_convertible<Callable, FunctionDeclaration>::value,
+		decltype(std::declval<typename std::decay<Callable>::type&>()(std::declval<ParamsList>()...))>::type;
+
 public:
 	/** @brief  Instantiate a delegate object
     */
@@ -140,8 +185,10 @@ public:
 	 */
 	template <class ClassType> __forceinline Delegate(MethodDeclaration<ClassType> m, ClassType* c)
 	{
+		static_assert(IsInline<MethodStorage<ClassType>>::value, "Method storage too large");
 		if(m != nullptr) {
-			impl = new MethodCaller<MethodDeclaration<ClassType>>(c, m);
+			new(storage) MethodStorage<ClassType>{c, m};
+			invoker = invokeMethod<ClassType>;
 		}
 	}
 
@@ -152,15 +199,26 @@ public:
 	__forceinline Delegate(FunctionDeclaration m)
 	{
 		if(m != nullptr) {
-			impl = new FunctionCaller<FunctionDeclaration, ReturnType, ParamsList...>(m);
+			new(storage) FunctionDeclaration(m);
+			invoker = invokeFunction;
 		}
 	}
 
+	// Lambda or other function object
+	/** @brief  Delegate a callable object, such as a lambda with captures
+	 *  @param  callable The object to copy or move into the delegate
+	 *  @note   Only objects which don't fit in the delegate's internal storage require a heap allocation.
+	 *  Construction is explicit so overloads taking both Delegate and std::function remain unambiguous.
+	 */
+	template <class Callable, typename = EnableIfCallable<Callable>>
+	__forceinline explicit Delegate(Callable&& callable)
+	{
+		assign<typename std::decay<Callable>::type>(std::forward<Callable>(callable));
+	}
+
 	__forceinline ~Delegate()
 	{
-		if(impl != nullptr) {
-			impl->decrease();
-		}
+		release();
 	}
 
 	/** @brief  Invoke a delegate
@@ -169,7 +227,7 @@ public:
      */
 	__forceinline ReturnType operator()(ParamsList... params) const
 	{
-		return impl->invoke(params...);
+		return invoker(storage, std::forward<ParamsList>(params)...);
 	}
 
 	/** @brief  Move a delegate from another object
@@ -177,8 +235,7 @@ public:
      */
 	__forceinline Delegate(Delegate&& that)
 	{
-		impl = that.impl;
-		that.impl = nullptr;
+		take(that);
 	}
 
 	/** @brief  Copy a delegate from another Delegate object
@@ -195,7 +252,10 @@ public:
      */
 	__forceinline Delegate& operator=(const Delegate& that) // copy assignment
 	{
-		copy(that);
+		if(this != &that) {
+			release();
+			copy(that);
+		}
 		return *this;
 	}
 
@@ -206,12 +266,8 @@ public:
 	Delegate& operator=(Delegate&& that) // move assignment
 	{
 		if(this != &that) {
-			if(impl != nullptr) {
-				impl->decrease();
-			}
-
-			impl = that.impl;
-			that.impl = nullptr;
+			release();
+			take(that);
 		}
 		return *this;
 	}
@@ -221,25 +277,98 @@ public:
      */
 	__forceinline operator bool() const
 	{
-		return impl != nullptr;
+		return invoker != nullptr;
+	}
+
+	/** @brief Determine if the delegate required a heap allocation
+	 *  @retval bool true if the callable was too large or complex to store internally
+	 */
+	__forceinline bool isAllocated() const
+	{
+		return invoker == invokeCaller;
 	}
 
 protected:
+	// Both delegates hold the same callable afterwards; only allocated callers need reference counting
 	void copy(const Delegate& other)
 	{
-		if(impl != other.impl) {
-			if(impl != nullptr) {
-				impl->decrease();
-			}
-			impl = other.impl;
-			if(impl != nullptr) {
-				impl->increase();
-			}
+		memcpy(storage, other.storage, sizeof(storage));
+		invoker = other.invoker;
+		if(isAllocated()) {
+			getCaller()->increase();
+		}
+	}
+
+private:
+	template <class Callable> typename std::enable_if<IsInline<Callable>::value>::type assign(Callable&& callable)
+	{
+		new(storage) Callable(std::move(callable));
+		invoker = invokeCallable<Callable>;
+	}
+
+	template <class Callable> typename std::enable_if<IsInline<Callable>::value>::type assign(const Callable& callable)
+	{
+		new(storage) Callable(callable);
+		invoker = invokeCallable<Callable>;
+	}
+
+	template <class Callable, class T> typename std::enable_if<!IsInline<Callable>::value>::type assign(T&& callable)
+	{
+		Caller* caller = new FunctionCaller<Callable, ReturnType, ParamsList...>(std::forward<T>(callable));
+		memcpy(storage, &caller, sizeof(caller));
+		invoker = invokeCaller;
+	}
+
+	void take(Delegate& other)
+	{
+		memcpy(storage, other.storage, sizeof(storage));
+		invoker = other.invoker;
+		other.invoker = nullptr;
+	}
+
+	void release()
+	{
+		if(isAllocated()) {
+			getCaller()->decrease();
 		}
+		invoker = nullptr;
+	}
+
+	Caller* getCaller() const
+	{
+		Caller* caller;
+		memcpy(&caller, storage, sizeof(caller));
+		return caller;
+	}
+
+	static ReturnType invokeFunction(const void* storage, ParamsList... params)
+	{
+		return (*static_cast<const FunctionDeclaration*>(storage))(std::forward<ParamsList>(params)...);
+	}
+
+	template <class ClassType> static ReturnType invokeMethod(const void* storage, ParamsList... params)
+	{
+		auto m = static_cast<const MethodStorage<ClassType>*>(storage);
+		return (m->object->*m->method)(std::forward<ParamsList>(params)...);
+	}
+
+	template <class Callable> static ReturnType invokeCallable(const void* storage, ParamsList... params)
+	{
+		// Callables may have a non-const operator() (e.g. mutable lambdas), as with std::function
+		auto callable = const_cast<Callable*>(static_cast<const Callable*>(storage));
+		return (*callable)(std::forward<ParamsList>(params)...);
+	}
+
+	static ReturnType invokeCaller(const void* storage, ParamsList... params)
+	{
+		Caller* caller;
+		memcpy(&caller, storage, sizeof(caller));
+		return caller->invoke(std::forward<ParamsList>(params)...);
 	}
 
 private:
-	IDelegateCaller<ReturnType, ParamsList...>* impl = nullptr;
+	alignas(void*) uint8_t storage[DELEGATE_STORAGE_SIZE] = {};
+	Invoker invoker = nullptr;
 };
 
 /** @} */
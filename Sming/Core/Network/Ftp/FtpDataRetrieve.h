@@ -11,35 +11,32 @@
 #pragma once
 
 #include "FtpDataStream.h"
-#include "FileSystem.h"
+#include "Data/Stream/FileStream.h"
 
 class FtpDataRetrieve : public FtpDataStream
 {
 public:
 	FtpDataRetrieve(FtpServerConnection* connection, const String& fileName)
-		: FtpDataStream(connection), file(fileOpen(fileName, eFO_ReadOnly))
+		: FtpDataStream(connection), stream(fileName)
 	{
 	}
 
-	~FtpDataRetrieve()
-	{
-		fileClose(file);
-	}
-
 	void transferData(TcpConnectionEvent sourceEvent) override
 	{
 		if(completed) {
 			return;
 		}
-		char buf[1024];
-		int len = fileRead(file, buf, sizeof(buf));
-		write(buf, len, TCP_WRITE_FLAG_COPY);
-		if(fileIsEOF(file)) {
+
+		// Fill the send window, parent class finishes transfer once all data has been acknowledged
+		TcpConnection::write(&stream);
+		if(!stream.isValid() || stream.isFinished()) {
 			completed = true;
-			finishTransfer();
+			if(written == 0) {
+				finishTransfer();
+			}
 		}
 	}
 
 private:
-	file_t file;
+	FileStream stream;
 };
@@ -11,19 +11,28 @@
 #pragma once
 
 #include "FtpDataStream.h"
-#include "FileSystem.h"
+#include "Data/Stream/FileStream.h"
+
+/**
+ * @brief Incoming data is collected into blocks of this size before writing to file
+ * @note Writing whole blocks is considerably faster than writing each packet as it arrives
+ */
+#ifndef FTP_STORE_BUFFER_SIZE
+#define FTP_STORE_BUFFER_SIZE 2048
+#endif
 
 class FtpDataStore : public FtpDataStream
 {
 public:
 	FtpDataStore(FtpServerConnection* connection, const String& fileName)
-		: FtpDataStream(connection), file(fileOpen(fileName, eFO_WriteOnly | eFO_CreateNewAlways))
+		: FtpDataStream(connection), stream(fileName, eFO_WriteOnly | eFO_CreateNewAlways)
 	{
 	}
 
 	~FtpDataStore()
 	{
-		fileClose(file);
+		flushBuffer();
+		delete[] buffer;
 	}
 
 	err_t onReceive(pbuf* buf) override
@@ -34,19 +43,49 @@ public:
 
 		if(buf == nullptr) {
 			completed = true;
+			flushBuffer();
 			response(226, "Transfer completed");
 			return TcpConnection::onReceive(buf);
 		}
 
-		pbuf* cur = buf;
-		while(cur != nullptr && cur->len > 0) {
-			fileWrite(file, (uint8_t*)cur->payload, cur->len);
-			cur = cur->next;
+		if(buffer == nullptr) {
+			buffer = new uint8_t[FTP_STORE_BUFFER_SIZE];
+		}
+
+		for(pbuf* cur = buf; cur != nullptr; cur = cur->next) {
+			auto data = static_cast<const uint8_t*>(cur->payload);
+			size_t len = cur->len;
+			while(len != 0) {
+				if(buffer == nullptr) {
+					// Out of memory, write directly
+					stream.write(data, len);
+					break;
+				}
+				size_t n = std::min(len, size_t(FTP_STORE_BUFFER_SIZE - bufferLength));
+				memcpy(&buffer[bufferLength], data, n);
+				bufferLength += n;
+				data += n;
+				len -= n;
+				if(bufferLength == FTP_STORE_BUFFER_SIZE) {
+					flushBuffer();
+				}
+			}
 		}
 
 		return TcpConnection::onReceive(buf);
 	}
 
 private:
-	file_t file;
+	void flushBuffer()
+	{
+		if(bufferLength != 0) {
+			stream.write(buffer, bufferLength);
+			bufferLength = 0;
+		}
+	}
+
+private:
+	FileStream stream;
+	uint8_t* buffer = nullptr;
+	size_t bufferLength = 0;
 };
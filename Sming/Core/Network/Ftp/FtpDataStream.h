@@ -30,7 +30,7 @@ public:
 	err_t onSent(uint16_t len) override
 	{
 		sent += len;
-		if(written < sent || !completed) {
+		if(sent < written || !completed) {
 			return TcpConnection::onSent(len);
 		}
 		finishTransfer();
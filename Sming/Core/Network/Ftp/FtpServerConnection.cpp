@@ -13,62 +13,118 @@
 #include "FtpDataRetrieve.h"
 #include "FtpDataFileList.h"
 #include "../FtpServer.h"
-#include "Network/NetUtils.h"
+
+// Verbs are at most four characters so can be compared as a single word
+static constexpr uint32_t verbCode(const char* verb, unsigned i = 0)
+{
+	return (i == 4 || verb[i] == '\0') ? 0 : (uint32_t(uint8_t(verb[i])) << (i * 8)) | verbCode(verb, i + 1);
+}
+
+static const uint32_t commandCodes[] PROGMEM = {
+#define XX(verb) verbCode(#verb),
+	FTP_COMMAND_MAP(XX)
+#undef XX
+};
+
+FtpCommand FtpServerConnection::getCommand(const char* verb)
+{
+	if(strlen(verb) > 4) {
+		return FTP_CMD_UNKNOWN;
+	}
+
+	uint32_t code = verbCode(verb);
+	for(unsigned i = 0; i < ARRAY_SIZE(commandCodes); ++i) {
+		if(pgm_read_dword(&commandCodes[i]) == code) {
+			return FtpCommand(i);
+		}
+	}
+
+	return FTP_CMD_UNKNOWN;
+}
 
 err_t FtpServerConnection::onReceive(pbuf* buf)
 {
 	if(buf == nullptr) {
 		return ERR_OK;
 	}
-	int prev = 0;
 
-	while(true) {
-		int p = NetUtils::pbufFindStr(buf, "\r\n", prev);
-		if(p < 0 || p - prev > MAX_FTP_CMD) {
-			break;
-		}
-		int split = NetUtils::pbufFindChar(buf, ' ', prev);
-		String cmd, data;
-		if(split >= 0 && split < p) {
-			cmd = NetUtils::pbufStrCopy(buf, prev, split - prev);
-			split++;
-			data = NetUtils::pbufStrCopy(buf, split, p - split);
-		} else {
-			cmd = NetUtils::pbufStrCopy(buf, prev, p - prev);
+	for(pbuf* cur = buf; cur != nullptr; cur = cur->next) {
+		auto data = static_cast<const char*>(cur->payload);
+		for(unsigned i = 0; i < cur->len; ++i) {
+			char c = data[i];
+			if(c == '\n') {
+				processLine();
+			} else if(commandLength < MAX_FTP_CMD) {
+				commandBuffer[commandLength++] = c;
+			} else {
+				commandOverflow = true;
+			}
 		}
-		debug_d("%s: '%s'", cmd.c_str(), data.c_str());
-		onCommand(cmd, data);
-		prev = p + 1;
 	}
 
 	return ERR_OK;
 }
 
-void FtpServerConnection::cmdPort(const String& data)
+void FtpServerConnection::processLine()
 {
-	int last = getSplitterPos(data, ',', 4);
-	if(last < 0) {
-		response(550); // Invalid arguments
-					   //return;
-	}
-	int ipEnd = getSplitterPos(data, ',', 3);
-	String sip = data.substring(0, ipEnd);
-	sip.replace(',', '.');
-	ip = sip;
-	String ps1 = data.substring(ipEnd + 1, last);
-	String ps2 = data.substring(last + 1);
-	int p1 = ps1.toInt();
-	int p2 = ps2.toInt();
-	port = (p1 << 8) | p2;
+	unsigned length = commandLength;
+	bool overflow = commandOverflow;
+	commandLength = 0;
+	commandOverflow = false;
+
+	if(overflow) {
+		response(500, F("Command too long"));
+		return;
+	}
+
+	if(length != 0 && commandBuffer[length - 1] == '\r') {
+		--length;
+	}
+	if(length == 0) {
+		return;
+	}
+	commandBuffer[length] = '\0';
+
+	// Split verb from arguments, converting verb to upper case
+	char* data = commandBuffer;
+	while(*data != '\0' && *data != ' ') {
+		*data = toupper(uint8_t(*data));
+		++data;
+	}
+	if(*data == ' ') {
+		*data++ = '\0';
+	}
+
+	debug_d("%s: '%s'", commandBuffer, data);
+	onCommand(getCommand(commandBuffer), commandBuffer, data);
+}
+
+void FtpServerConnection::cmdPort(const char* data)
+{
+	// h1,h2,h3,h4,p1,p2
+	uint8_t values[6];
+	const char* p = data;
+	for(unsigned i = 0; i < ARRAY_SIZE(values); ++i) {
+		char* end;
+		unsigned long value = strtoul(p, &end, 10);
+		if(end == p || value > 0xFF || (i + 1 < ARRAY_SIZE(values) && *end != ',')) {
+			response(501); // Invalid arguments
+			return;
+		}
+		values[i] = value;
+		p = end + 1;
+	}
+
+	ip = IPAddress(values[0], values[1], values[2], values[3]);
+	port = (values[4] << 8) | values[5];
 	debug_d("connection to: %s, %d", ip.toString().c_str(), port);
 	response(200);
 }
 
-void FtpServerConnection::onCommand(String cmd, String data)
+void FtpServerConnection::onCommand(FtpCommand command, const char* cmd, const char* data)
 {
-	cmd.toUpperCase();
 	// We ready to quit always :)
-	if(cmd == _F("QUIT")) {
+	if(command == FTP_CMD_QUIT) {
 		response(221);
 		close();
 		return;
@@ -76,10 +132,10 @@ void FtpServerConnection::onCommand(String cmd, String data)
 
 	// Strong security check :)
 	if(state == eFCS_Authorization) {
-		if(cmd == _F("USER")) {
+		if(command == FTP_CMD_USER) {
 			userName = data;
 			response(331);
-		} else if(cmd == _F("PASS")) {
+		} else if(command == FTP_CMD_PASS) {
 			if(server->checkUser(userName, data)) {
 				userName = "";
 				state = eFCS_Active;
@@ -92,65 +148,75 @@ void FtpServerConnection::onCommand(String cmd, String data)
 		return;
 	}
 
-	if(state == eFCS_Active) {
-		if(cmd == _F("SYST")) {
-			response(215, F("Windows_NT: Sming Framework")); // Why not? It's look like Windows :)
-		} else if(cmd == _F("PWD")) {
-			response(257, F("\"/\""));
-		} else if(cmd == _F("PORT")) {
-			cmdPort(data);
-		} else if(cmd == _F("CWD")) {
-			if(data == "/")
-				response(250);
-			else
-				response(550);
-		} else if(cmd == _F("TYPE")) {
+	if(state != eFCS_Active) {
+		debug_e("!!!CASE NOT IMPLEMENTED?!!!");
+		return;
+	}
+
+	switch(command) {
+	case FTP_CMD_SYST:
+		response(215, F("Windows_NT: Sming Framework")); // Why not? It's look like Windows :)
+		break;
+
+	case FTP_CMD_PWD:
+		response(257, F("\"/\""));
+		break;
+
+	case FTP_CMD_PORT:
+		cmdPort(data);
+		break;
+
+	case FTP_CMD_CWD:
+		if(strcmp(data, "/") == 0)
 			response(250);
-		}
-		/*else if (cmd == _F("SIZE"))
-		{
-			response(213, String(fileGetSize(makeFileName(data, false))));
-		}*/
-		else if(cmd == _F("DELE")) {
-			String name = makeFileName(data, false);
-			if(fileExist(name)) {
-				fileDelete(name);
-				response(250);
-			} else
-				response(550);
-		}
-		/*else if (cmd == _F("RNFR")) // Bugs!
-		{
-			renameFrom = data;
-			response(350);
-		}
-		else if (cmd == _F("RNTO"))
-		{
-			if (fileExist(renameFrom))
-			{
-				fileRename(renameFrom, data);
-				response(250);
-			}
-			else
-				response(550);
-		}*/
-		else if(cmd == _F("RETR")) {
-			createDataConnection(new FtpDataRetrieve(this, makeFileName(data, false)));
-		} else if(cmd == _F("STOR")) {
-			createDataConnection(new FtpDataStore(this, makeFileName(data, true)));
-		} else if(cmd == _F("LIST")) {
-			createDataConnection(new FtpDataFileList(this));
-		} else if(cmd == _F("PASV")) {
-			response(500, F("Passive mode not supported"));
-		} else if(cmd == _F("NOOP")) {
-			response(200);
-		} else if(!server->onCommand(cmd, data, *this))
-			response(502, F("Not supported"));
+		else
+			response(550);
+		break;
 
-		return;
+	case FTP_CMD_TYPE:
+		// Files are always transferred as stored, i.e. binary
+		response(200);
+		break;
+
+	case FTP_CMD_DELE: {
+		String name = makeFileName(data, false);
+		if(fileExist(name)) {
+			fileDelete(name);
+			response(250);
+		} else
+			response(550);
+		break;
+	}
+
+	case FTP_CMD_RETR: {
+		String name = makeFileName(data, false);
+		if(fileExist(name)) {
+			createDataConnection(new FtpDataRetrieve(this, name));
+		} else
+			response(550);
+		break;
 	}
 
-	debug_e("!!!CASE NOT IMPLEMENTED?!!!");
+	case FTP_CMD_STOR:
+		createDataConnection(new FtpDataStore(this, makeFileName(data, true)));
+		break;
+
+	case FTP_CMD_LIST:
+		createDataConnection(new FtpDataFileList(this));
+		break;
+
+	case FTP_CMD_PASV:
+		response(500, F("Passive mode not supported"));
+		break;
+
+	case FTP_CMD_NOOP:
+		response(200);
+		break;
+
+	default:
+		if(!server->onCommand(cmd, data, *this))
+			response(502, F("Not supported"));
+	}
 }
 
 err_t FtpServerConnection::onSent(uint16_t len)
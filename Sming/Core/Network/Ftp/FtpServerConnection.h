@@ -16,6 +16,33 @@
 
 #define MAX_FTP_CMD 255
 
+/**
+ * @brief Commands handled directly by the server
+ * @note Anything else is passed to `FtpServer::onCommand()`
+ */
+#define FTP_COMMAND_MAP(XX)                                                                                            \
+	XX(USER)                                                                                                           \
+	XX(PASS)                                                                                                           \
+	XX(QUIT)                                                                                                           \
+	XX(SYST)                                                                                                           \
+	XX(PWD)                                                                                                            \
+	XX(PORT)                                                                                                           \
+	XX(CWD)                                                                                                            \
+	XX(TYPE)                                                                                                           \
+	XX(DELE)                                                                                                           \
+	XX(RETR)                                                                                                           \
+	XX(STOR)                                                                                                           \
+	XX(LIST)                                                                                                           \
+	XX(PASV)                                                                                                           \
+	XX(NOOP)
+
+enum FtpCommand {
+#define XX(verb) FTP_CMD_##verb,
+	FTP_COMMAND_MAP(XX)
+#undef XX
+		FTP_CMD_UNKNOWN
+};
+
 class FtpServer;
 
 enum FtpConnectionState { eFCS_Ready, eFCS_Authorization, eFCS_Active };
@@ -37,14 +64,38 @@ public:
 
 	void dataTransferFinished(TcpConnection* connection);
 
+	/**
+	 * @brief Identify a command verb
+	 * @param verb Must be in upper case
+	 * @retval FtpCommand FTP_CMD_UNKNOWN if not handled directly by the server
+	 */
+	static FtpCommand getCommand(const char* verb);
+
 protected:
-	virtual void onCommand(String cmd, String data);
+	/**
+	 * @brief Handle a command received on the control connection
+	 * @param command Identifies the verb
+	 * @param cmd The verb, in upper case
+	 * @param data Arguments, empty if there are none
+	 */
+	virtual void onCommand(FtpCommand command, const char* cmd, const char* data);
+
+	/**
+	 * @deprecated Override `onCommand(FtpCommand, const char*, const char*)` instead.
+	 * This is final so existing overrides fail to build, rather than silently never being called.
+	 */
+	virtual void onCommand(String cmd, String data) final SMING_DEPRECATED
+	{
+		cmd.toUpperCase();
+		onCommand(getCommand(cmd.c_str()), cmd.c_str(), data.c_str());
+	}
+
 	virtual void response(int code, String text = "");
 
 	int getSplitterPos(const String& data, char splitter, uint8_t number);
 	String makeFileName(String name, bool shortIt);
 
-	void cmdPort(const String& data);
+	void cmdPort(const char* data);
 	void createDataConnection(TcpConnection* connection);
 
 	bool isCanTransfer()
@@ -52,6 +103,9 @@ protected:
 		return canTransfer;
 	}
 
+private:
+	void processLine();
+
 private:
 	FtpServer* server = nullptr;
 	FtpConnectionState state = eFCS_Ready;
@@ -62,6 +116,11 @@ private:
 	int port = 0;
 	TcpConnection* dataConnection = nullptr;
 	bool canTransfer = true;
+
+	// Commands may be split across, or share, packets so are assembled here
+	char commandBuffer[MAX_FTP_CMD + 1];
+	uint16_t commandLength = 0;
+	bool commandOverflow = false;
 };
 
 typedef FtpServerConnection FTPServerConnection SMING_DEPRECATED; // @deprecated Use `FtpServerConnection` instead
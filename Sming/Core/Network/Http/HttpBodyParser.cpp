@@ -15,88 +15,145 @@
  ****/
 
 #include "HttpBodyParser.h"
-#include "Network/WebHelpers/escape.h"
+#include <stringutil.h>
+#include <ctype.h>
 
 /*
  * Content is received in chunks which we need to reassemble into name=value pairs.
- * This structure stores the temporary values during parsing.
+ * Characters are un-escaped as they arrive into a single buffer, allocated once per request,
+ * which holds the current name followed by its value.
  */
-typedef struct {
-	char searchChar = '=';
-	String postName;
-	String postValue;
-} FormUrlParserState;
+struct FormUrlParserState {
+	uint16_t length = 0;	 ///< Decoded characters in buffer
+	uint16_t nameLength = 0; ///< Length of name at start of buffer, valid once '=' is seen
+	bool inValue = false;
+	bool overflow = false;	 ///< Field is too long and will be discarded
+	uint8_t escapeLength = 0; ///< Number of characters of an incomplete %XX sequence
+	char escape = 0;		  ///< First hex digit of an incomplete sequence
+	char buffer[HTTP_FORM_BUFFER_SIZE];
+
+	void append(char c)
+	{
+		if(length < sizeof(buffer)) {
+			buffer[length++] = c;
+		} else {
+			overflow = true;
+		}
+	}
 
-/*
- * The incoming URL is parsed
- */
-void formUrlParser(HttpRequest& request, const char* at, int length)
+	// An incomplete or invalid escape sequence is kept as literal text
+	void flushEscape()
+	{
+		if(escapeLength > 0) {
+			append('%');
+		}
+		if(escapeLength > 1) {
+			append(escape);
+		}
+		escapeLength = 0;
+	}
+
+	void process(HttpParams& params, const char* at, unsigned length);
+	void completeField(HttpParams& params);
+};
+
+void FormUrlParserState::process(HttpParams& params, const char* at, unsigned length)
 {
-	auto state = static_cast<FormUrlParserState*>(request.args);
+	for(unsigned i = 0; i < length; ++i) {
+		char c = at[i];
+
+		if(escapeLength != 0) {
+			if(isxdigit((unsigned char)c)) {
+				if(escapeLength == 1) {
+					escape = c;
+					escapeLength = 2;
+				} else {
+					append((unhex(escape) << 4) | unhex(c));
+					escapeLength = 0;
+				}
+				continue;
+			}
+			flushEscape();
+		}
 
-	if(length == PARSE_DATASTART) {
-		delete state;
-		request.args = new FormUrlParserState;
-		return;
+		switch(c) {
+		case '%':
+			escapeLength = 1;
+			break;
+		case '+':
+			append(' ');
+			break;
+		case '=':
+			if(inValue) {
+				append(c);
+			} else {
+				nameLength = this->length;
+				inValue = true;
+			}
+			break;
+		case '&':
+			completeField(params);
+			break;
+		default:
+			append(c);
+		}
 	}
+}
 
-	assert(state != nullptr);
-
-	auto& params = request.postParams;
+void FormUrlParserState::completeField(HttpParams& params)
+{
+	flushEscape();
+	if(!inValue) {
+		nameLength = length;
+	}
 
-	if(length == PARSE_DATAEND) {
-		// Store last parameter, if there is one
-		if(state->postName.length() != 0) {
-			uri_unescape_inplace(state->postValue);
-			params[state->postName] = state->postValue;
+	if(overflow) {
+		debug_w("Form field too long, discarded");
+	} else if(nameLength != 0) {
+		String name(buffer, nameLength);
+		if(params.count() < HTTP_FORM_MAX_FIELDS || params.contains(name)) {
+			params[name] = String(&buffer[nameLength], length - nameLength);
+		} else {
+			debug_w("Too many form fields, '%s' discarded", name.c_str());
 		}
+	}
 
-		delete state;
-		request.args = nullptr;
+	length = 0;
+	nameLength = 0;
+	inValue = false;
+	overflow = false;
+}
+
+size_t formUrlParser(HttpRequest& request, const char* at, int length)
+{
+	auto state = static_cast<FormUrlParserState*>(request.args);
 
-		return;
+	if(length == PARSE_DATASTART) {
+		delete state;
+		request.args = new FormUrlParserState;
+		return 0;
 	}
 
 	if(state == nullptr) {
 		debug_e("Invalid request argument");
-		return;
+		return 0;
 	}
 
-	while(length > 0) {
-		// Look for search character ('=' or '&') in received text
-		auto found = static_cast<const char*>(memchr(at, state->searchChar, length));
-		unsigned foundLength = (found == nullptr) ? length : (found - at);
-
-		if(foundLength != 0) {
-			if(state->searchChar == '=') {
-				state->postName.concat(at, foundLength);
-			} else {
-				state->postValue.concat(at, foundLength);
-			}
-		}
+	if(length == PARSE_DATAEND) {
+		// Store last parameter, if there is one
+		state->completeField(request.postParams);
 
-		if(found == nullptr) {
-			break;
-		}
+		delete state;
+		request.args = nullptr;
 
-		if(state->searchChar == '=') {
-			uri_unescape_inplace(state->postName);
-			state->searchChar = '&';
-		} else {
-			uri_unescape_inplace(state->postValue);
-			params[state->postName] = state->postValue;
-			state->searchChar = '=';
-			// Keep String memory allocated, but clear content
-			state->postName.setLength(0);
-			state->postValue.setLength(0);
-		}
-		++foundLength; // Skip the '=' or '&'
-		at += foundLength;
-		length -= foundLength;
+		return 0;
 	}
+
+	state->process(request.postParams, at, length);
+	return length;
 }
 
-void bodyToStringParser(HttpRequest& request, const char* at, int length)
+size_t bodyToStringParser(HttpRequest& request, const char* at, int length)
 {
 	auto data = static_cast<String*>(request.args);
 
@@ -104,20 +161,24 @@ void bodyToStringParser(HttpRequest& request, const char* at, int length)
 		delete data;
 		data = new String();
 		request.args = data;
-		return;
+		return 0;
 	}
 
 	if(data == nullptr) {
 		debug_e("Invalid request argument");
-		return;
+		return 0;
 	}
 
 	if(length == PARSE_DATAEND || length < 0) {
 		request.setBody(*data);
 		delete data;
 		request.args = nullptr;
-		return;
+		return 0;
+	}
+
+	if(!data->concat(at, length)) {
+		return 0;
 	}
 
-	data->concat(at, length);
+	return length;
 }
@@ -15,6 +15,21 @@
 #include "HttpCommon.h"
 #include "HttpRequest.h"
 
+/// Maximum decoded length of a form field name plus its value
+#ifndef HTTP_FORM_BUFFER_SIZE
+#define HTTP_FORM_BUFFER_SIZE 512
+#endif
+
+/// Maximum number of form fields stored in HttpRequest::postParams
+#ifndef HTTP_FORM_MAX_FIELDS
+#define HTTP_FORM_MAX_FIELDS 32
+#endif
+
+/// Maximum length of a multipart part header line, parts with longer header lines are discarded
+#ifndef HTTP_MULTIPART_HEADER_SIZE
+#define HTTP_MULTIPART_HEADER_SIZE 256
+#endif
+
 /** @brief special length values passed to parse functions */
 const int PARSE_DATASTART = -1; ///< Start of incoming data
 const int PARSE_DATAEND = -2;   ///< End of incoming data
@@ -24,10 +39,13 @@ const int PARSE_DATAEND = -2;   ///< End of incoming data
  * @param request
  * @param at
  * @param length Negative lengths have special meanings
+ * @retval size_t Number of bytes processed; if less than length then the request fails
+ * with a content error. Return value is ignored for special lengths.
+ * @note Parsers previously returned `void`, so must now return `length` to accept all the data.
  * @see `PARSE_DATASTART`
  * @see `PARSE_DATAEND`
  */
-typedef Delegate<void(HttpRequest& request, const char* at, int length)> HttpBodyParserDelegate;
+typedef Delegate<size_t(HttpRequest& request, const char* at, int length)> HttpBodyParserDelegate;
 
 /**
  * @brief Maps body parsers to a specific content type
@@ -37,12 +55,30 @@ typedef HashMap<String, HttpBodyParserDelegate> BodyParsers;
 /**
  * @brief Parses application/x-www-form-urlencoded body data
  * @see `HttpBodyParserDelegate`
+ * @note Fields are un-escaped as they arrive using a single buffer of `HTTP_FORM_BUFFER_SIZE` bytes.
+ * Longer fields, and any beyond `HTTP_FORM_MAX_FIELDS`, are discarded.
+ */
+size_t formUrlParser(HttpRequest& request, const char* at, int length);
+
+/**
+ * @brief Parses multipart/form-data body data
+ * @see `HttpBodyParserDelegate`
+ * @note Each part is written directly to the stream in `HttpRequest::uploads` matching its field name as
+ * content arrives, so files of any size are received in constant memory. For example, in the resource
+ * `onHeadersComplete` handler:
+ *
+ * 		request.uploads["firmware"] = new FileStream("fw.bin", eFO_CreateNewAlways | eFO_WriteOnly);
+ *
+ * Data is written synchronously from the TCP receive callback so no further content is processed until
+ * the write completes; if it fails the request fails with a content error.
+ * Parts without a file name are stored in `HttpRequest::postParams` subject to the same limits as
+ * `formUrlParser()`. Files without a matching stream are discarded.
  */
-void formUrlParser(HttpRequest& request, const char* at, int length);
+size_t formMultipartParser(HttpRequest& request, const char* at, int length);
 
 /**
  * @brief Stores the complete body into memory
  * @see `HttpBodyParserDelegate`
  * @note The content later can be retrieved by calling request.getBody()
  */
-void bodyToStringParser(HttpRequest& request, const char* at, int length);
+size_t bodyToStringParser(HttpRequest& request, const char* at, int length);
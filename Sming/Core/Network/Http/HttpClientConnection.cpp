@@ -53,9 +53,6 @@ bool HttpClientConnection::send(HttpRequest* request)
 #ifdef ENABLE_SSL
 	// Based on the URL decide if we should reuse the SSL and TCP pool
 	if(useSsl) {
-		if(sslSessionId == nullptr) {
-			sslSessionId = new SslSessionId;
-		}
 		addSslOptions(request->getSslOptions());
 		pinCertificate(request->sslFingerprints);
 		setSslKeyCert(request->sslKeyCertPair);
@@ -283,8 +280,7 @@ REENTER:
 	case eHCS_SendingBody: {
 		if(sendRequestBody(outgoingRequest)) {
 			state = eHCS_Ready;
-			delete stream;
-			stream = nullptr;
+			releaseStream(stream);
 			goto REENTER;
 		}
 	}
@@ -352,7 +348,7 @@ bool HttpClientConnection::sendRequestBody(HttpRequest* request)
 			return true;
 		}
 
-		delete stream;
+		releaseStream(stream);
 		if(request->headers[HTTP_HEADER_TRANSFER_ENCODING] == _F("chunked")) {
 			stream = new ChunkedStream(request->bodyStream);
 		} else {
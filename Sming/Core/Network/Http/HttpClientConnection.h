@@ -39,10 +39,6 @@ public:
 		while(waitingQueue.count() != 0) {
 			delete waitingQueue.dequeue();
 		}
-
-#ifdef ENABLE_SSL
-		delete sslSessionId;
-#endif
 	}
 
 	bool connect(const String& host, int port, bool useSsl = false, uint32_t sslOptions = 0) override;
@@ -56,6 +52,14 @@ public:
 
 	void reset() override;
 
+	/** @brief Number of requests queued or in progress
+	 *  @retval unsigned 0 if the connection is idle
+	 */
+	unsigned getRequestCount() const
+	{
+		return waitingQueue.count() + executionQueue.count() + (incomingRequest != nullptr ? 1 : 0);
+	}
+
 protected:
 	// HTTP parser methods
 
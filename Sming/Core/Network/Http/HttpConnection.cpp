@@ -175,6 +175,10 @@ void HttpConnection::onHttpError(http_errno error)
 bool HttpConnection::onTcpReceive(TcpClient& client, char* data, int size)
 {
 	int parsedBytes = http_parser_execute(&parser, &parserSettings, data, size);
+	if(HTTP_PARSER_ERRNO(&parser) == HPE_PAUSED) {
+		return onParserPaused(data + parsedBytes, size - parsedBytes);
+	}
+
 	if(HTTP_PARSER_ERRNO(&parser) != HPE_OK) {
 		// we ran into trouble - abort the connection
 		onHttpError(HTTP_PARSER_ERRNO(&parser));
@@ -203,6 +203,17 @@ protected:
 
 	virtual void onHttpError(http_errno error);
 
+	/** @brief Called when a parser callback has paused parsing
+	 * 	@param data Data which has not been parsed
+	 * 	@param size Number of bytes, may be 0
+	 * 	@retval bool true to continue, false to abort the connection
+	 * 	@note Any further data received whilst the parser is paused is also passed here.
+	 */
+	virtual bool onParserPaused(char* data, int size)
+	{
+		return false;
+	}
+
 	// TCP methods
 	virtual bool onTcpReceive(TcpClient& client, char* data, int size);
 
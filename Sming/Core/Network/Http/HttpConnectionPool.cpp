@@ -0,0 +1,165 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpConnectionPool.cpp
+ *
+ ****/
+
+#include "HttpConnectionPool.h"
+
+// How often to look for idle connections, in milliseconds
+#define IDLE_CHECK_INTERVAL 1000
+
+HttpClientConnection* HttpConnectionPool::getConnection(const String& key)
+{
+	// A connection with outstanding requests may be inside a callback, so only the timer deletes those
+	removeStale(false);
+
+	Entry* selected = nullptr;  // Most recently used idle connection
+	Entry* leastBusy = nullptr; // Busy connection with fewest outstanding requests
+	unsigned hostCount = 0;
+	for(auto& entry : entries) {
+		if(entry.connection == nullptr || entry.key != key || isStale(entry.connection)) {
+			continue;
+		}
+
+		++hostCount;
+		unsigned requestCount = entry.connection->getRequestCount();
+		if(requestCount == 0) {
+			if(selected == nullptr || int32_t(entry.lastUsed - selected->lastUsed) > 0) {
+				selected = &entry;
+			}
+		} else if(leastBusy == nullptr || requestCount < leastBusy->connection->getRequestCount()) {
+			leastBusy = &entry;
+		}
+	}
+
+	if(selected != nullptr) {
+		debug_d("HttpConnectionPool: Re-using idle connection to %s", key.c_str());
+		++stats.hits;
+	} else if(hostCount < HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST && (selected = createEntry(key)) != nullptr) {
+		debug_d("HttpConnectionPool: New connection to %s (%u of %u)", key.c_str(), hostCount + 1,
+				HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST);
+		++stats.misses;
+	} else if(leastBusy != nullptr) {
+		debug_d("HttpConnectionPool: Queueing request to %s", key.c_str());
+		selected = leastBusy;
+		++stats.queued;
+	} else {
+		debug_w("HttpConnectionPool: No connection available for %s", key.c_str());
+		return nullptr;
+	}
+
+	selected->lastUsed = millis();
+	if(!idleTimer.isStarted()) {
+		idleTimer.setIntervalMs(IDLE_CHECK_INTERVAL);
+		idleTimer.start();
+	}
+
+	return selected->connection;
+}
+
+HttpConnectionPool::Entry* HttpConnectionPool::createEntry(const String& key)
+{
+	Entry* free = nullptr;
+	Entry* oldestIdle = nullptr;
+	for(auto& entry : entries) {
+		if(entry.connection == nullptr) {
+			free = &entry;
+			break;
+		}
+		if(entry.connection->getRequestCount() != 0) {
+			continue;
+		}
+		if(oldestIdle == nullptr || int32_t(entry.lastUsed - oldestIdle->lastUsed) < 0) {
+			oldestIdle = &entry;
+		}
+	}
+
+	if(free == nullptr) {
+		if(oldestIdle == nullptr) {
+			// Every connection is busy
+			return nullptr;
+		}
+		debug_d("HttpConnectionPool: Pool full, closing idle connection to %s", oldestIdle->key.c_str());
+		evict(*oldestIdle);
+		free = oldestIdle;
+	}
+
+	free->connection = createConnection();
+	if(free->connection == nullptr) {
+		// Out of memory
+		return nullptr;
+	}
+	free->key = key;
+	return free;
+}
+
+void HttpConnectionPool::removeStale(bool includeBusy)
+{
+	for(auto& entry : entries) {
+		if(entry.connection == nullptr || !isStale(entry.connection)) {
+			continue;
+		}
+		if(!includeBusy && entry.connection->getRequestCount() != 0) {
+			continue;
+		}
+		debug_d("HttpConnectionPool: Removing stale connection to %s, state %d", entry.key.c_str(),
+				entry.connection->getConnectionState());
+		delete entry.connection;
+		entry = Entry();
+	}
+}
+
+void HttpConnectionPool::evict(Entry& entry)
+{
+	delete entry.connection;
+	entry = Entry();
+	++stats.evictions;
+}
+
+void HttpConnectionPool::checkIdle()
+{
+	removeStale(true);
+
+	uint32_t now = millis();
+	for(auto& entry : entries) {
+		if(entry.connection == nullptr) {
+			continue;
+		}
+		if(entry.connection->getRequestCount() != 0) {
+			// Idle time counts from when the last request completed
+			entry.lastUsed = now;
+		} else if(now - entry.lastUsed >= HTTP_CLIENT_IDLE_TIMEOUT * 1000U) {
+			debug_d("HttpConnectionPool: Closing idle connection to %s", entry.key.c_str());
+			evict(entry);
+		}
+	}
+
+	if(count() == 0) {
+		idleTimer.stop();
+	}
+}
+
+unsigned HttpConnectionPool::count() const
+{
+	unsigned n = 0;
+	for(auto& entry : entries) {
+		if(entry.connection != nullptr) {
+			++n;
+		}
+	}
+	return n;
+}
+
+void HttpConnectionPool::clear()
+{
+	idleTimer.stop();
+	for(auto& entry : entries) {
+		delete entry.connection;
+		entry = Entry();
+	}
+}
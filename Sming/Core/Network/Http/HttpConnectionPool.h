@@ -0,0 +1,114 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpConnectionPool.h
+ *
+ ****/
+
+#pragma once
+
+#include "HttpClientConnection.h"
+#include "Timer.h"
+
+/** @addtogroup httpclient
+ *  @{
+ */
+
+/// Maximum number of client connections kept open at once, across all hosts
+#ifndef HTTP_CLIENT_MAX_CONNECTIONS
+#define HTTP_CLIENT_MAX_CONNECTIONS 4
+#endif
+
+/// Maximum number of parallel connections to a single host:port
+#ifndef HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST
+#define HTTP_CLIENT_MAX_CONNECTIONS_PER_HOST 2
+#endif
+
+/// Idle connections are closed after this many seconds
+#ifndef HTTP_CLIENT_IDLE_TIMEOUT
+#define HTTP_CLIENT_IDLE_TIMEOUT 30
+#endif
+
+/** @brief Bounded pool of keep-alive client connections, keyed by "host:port"
+ *
+ *  A request is given the most recently used idle connection to its host, so the server sees a
+ *  steady stream on one connection and less-used ones are left to time out. If none is idle a new
+ *  connection is opened, up to the per-host limit, after which requests are queued on the
+ *  connection with the fewest outstanding requests. When the pool is full the least recently used
+ *  idle connection is closed to make room.
+ */
+class HttpConnectionPool
+{
+public:
+	struct Stats {
+		unsigned hits;		///< Requests which re-used an idle connection
+		unsigned misses;	///< Requests which opened a new connection
+		unsigned queued;	///< Requests queued behind others on a busy connection
+		unsigned evictions; ///< Idle connections closed by timeout or to make room
+	};
+
+	HttpConnectionPool()
+	{
+		idleTimer.setCallback(TimerDelegate(&HttpConnectionPool::checkIdle, this));
+	}
+
+	virtual ~HttpConnectionPool()
+	{
+		clear();
+	}
+
+	/** @brief Select a connection for a new request
+	 *  @param key Identifies the server, "host:port"
+	 *  @retval HttpClientConnection* nullptr if the pool is full of busy connections
+	 */
+	HttpClientConnection* getConnection(const String& key);
+
+	/** @brief Close all connections, discarding any queued requests
+	 */
+	void clear();
+
+	/** @brief Number of open connections
+	 */
+	unsigned count() const;
+
+	const Stats& getStats() const
+	{
+		return stats;
+	}
+
+	void resetStats()
+	{
+		stats = {};
+	}
+
+protected:
+	virtual HttpClientConnection* createConnection()
+	{
+		return new HttpClientConnection();
+	}
+
+	struct Entry {
+		String key;
+		HttpClientConnection* connection = nullptr;
+		uint32_t lastUsed = 0; ///< millis() when last busy
+	};
+
+	static bool isStale(HttpClientConnection* connection)
+	{
+		return connection->getConnectionState() > eTCS_Connecting && !connection->isActive();
+	}
+
+	Entry* createEntry(const String& key);
+	void removeStale(bool includeBusy);
+	void evict(Entry& entry);
+	void checkIdle();
+
+	Entry entries[HTTP_CLIENT_MAX_CONNECTIONS];
+	Stats stats = {};
+	Timer idleTimer;
+};
+
+/** @} */
@@ -39,11 +39,15 @@ public:
 		return 0;
 	}
 
+	/** @brief Prepare for another message
+	 *  @note Buffers are retained, so once a connection has received a few messages
+	 *  header parsing needs no further allocations for these
+	 */
 	void reset()
 	{
 		lastWasValue = true;
-		lastData = nullptr;
-		currentField = nullptr;
+		lastData.setLength(0);
+		currentField.setLength(0);
 	}
 
 private:
@@ -23,6 +23,87 @@ static FSTR_TABLE(FieldNameStrings) = {
 #undef XX
 };
 
+/*
+ * Field names are resolved using a perfect hash: each standard name maps to a unique slot in a small table,
+ * so lookup requires hashing the name once and a single comparison to confirm the match.
+ *
+ * The hash is FNV-1a applied to the name with ASCII letters folded to lower case. Field names are
+ * tokens so folding by setting bit 5 is sufficient; other characters may alias but any candidate is
+ * verified with a full comparison.
+ *
+ * The seed was chosen so that all standard names occupy distinct slots. This is checked at compile time,
+ * so if a new name is added to HTTP_HEADER_FIELDNAME_MAP which causes a collision the build will fail:
+ * pick another seed (or increase FIELDNAME_SLOT_BITS) to fix it.
+ */
+#define FIELDNAME_HASH_SEED 0x811ca331U
+#define FIELDNAME_HASH_PRIME 16777619U
+#define FIELDNAME_SLOT_BITS 6
+#define FIELDNAME_SLOT_COUNT (1U << FIELDNAME_SLOT_BITS)
+
+static constexpr uint32_t hashFieldNameChar(uint32_t hash, char c)
+{
+	return (hash ^ uint8_t(c | 0x20)) * FIELDNAME_HASH_PRIME;
+}
+
+// Recursive form for compile-time evaluation (C++11 constexpr functions cannot contain loops)
+static constexpr uint32_t hashFieldName(const char* name, unsigned length, uint32_t hash)
+{
+	return (length == 0) ? hash : hashFieldName(name + 1, length - 1, hashFieldNameChar(hash, *name));
+}
+
+static uint32_t hashFieldName(const char* name, unsigned length)
+{
+	uint32_t hash = FIELDNAME_HASH_SEED;
+	while(length-- != 0) {
+		hash = hashFieldNameChar(hash, *name++);
+	}
+	return hash;
+}
+
+static constexpr unsigned fieldNameSlot(uint32_t hash)
+{
+	return hash >> (32 - FIELDNAME_SLOT_BITS);
+}
+
+static constexpr uint32_t fieldNameHashes[] = {
+#define XX(_tag, _str, _comment) hashFieldName(_str, sizeof(_str) - 1, FIELDNAME_HASH_SEED),
+	HTTP_HEADER_FIELDNAME_MAP(XX)
+#undef XX
+};
+
+static constexpr unsigned fieldNameCount = ARRAY_SIZE(fieldNameHashes);
+
+static constexpr bool slotCollides(unsigned i, unsigned j)
+{
+	return (j < fieldNameCount) &&
+		   (fieldNameSlot(fieldNameHashes[i]) == fieldNameSlot(fieldNameHashes[j]) || slotCollides(i, j + 1));
+}
+
+static constexpr bool anySlotCollides(unsigned i)
+{
+	return (i < fieldNameCount) && (slotCollides(i, i + 1) || anySlotCollides(i + 1));
+}
+
+static_assert(fieldNameCount < FIELDNAME_SLOT_COUNT, "Too many HTTP field names for hash table");
+static_assert(!anySlotCollides(0), "HTTP field name hash collision: change FIELDNAME_HASH_SEED");
+
+/*
+ * Map hash slot to field name code (0 for empty slots).
+ * Built on first use as C++11 offers no convenient way to construct it at compile time.
+ */
+static const uint8_t* getFieldNameSlots()
+{
+	static uint8_t slots[FIELDNAME_SLOT_COUNT];
+	static bool initialised;
+	if(!initialised) {
+		for(unsigned i = 0; i < fieldNameCount; ++i) {
+			slots[fieldNameSlot(fieldNameHashes[i])] = i + 1;
+		}
+		initialised = true;
+	}
+	return slots;
+}
+
 String HttpHeaders::toString(HttpHeaderFieldName name) const
 {
 	if(name == HTTP_HEADER_UNKNOWN)
@@ -45,12 +126,58 @@ String HttpHeaders::toString(const String& name, const String& value)
 	return s;
 }
 
+size_t HttpHeaders::getOutputLength() const
+{
+	size_t length = 0;
+	for(unsigned i = 0; i < count(); ++i) {
+		auto name = keyAt(i);
+		if(name == HTTP_HEADER_UNKNOWN) {
+			continue;
+		}
+		if(name < HTTP_HEADER_CUSTOM) {
+			length += FieldNameStrings[name - 1]->length();
+		} else {
+			length += strlen(customFieldNames[name - HTTP_HEADER_CUSTOM]);
+		}
+		length += 2 + valueAt(i).length() + 2; // ": " value "\r\n"
+	}
+	return length;
+}
+
+bool HttpHeaders::appendTo(String& str) const
+{
+	if(!str.reserve(str.length() + getOutputLength())) {
+		return false;
+	}
+
+	for(unsigned i = 0; i < count(); ++i) {
+		auto name = keyAt(i);
+		if(name == HTTP_HEADER_UNKNOWN) {
+			continue;
+		}
+		if(name < HTTP_HEADER_CUSTOM) {
+			auto& fstr = *FieldNameStrings[name - 1];
+			auto len = str.length();
+			str.setLength(len + fstr.length());
+			memcpy_P(str.begin() + len, fstr.data(), fstr.length());
+		} else {
+			str.concat(customFieldNames[name - HTTP_HEADER_CUSTOM]);
+		}
+		str.concat(": ", 2);
+		str.concat(valueAt(i));
+		str.concat("\r\n", 2);
+	}
+
+	return true;
+}
+
 HttpHeaderFieldName HttpHeaders::fromString(const String& name) const
 {
+	unsigned slot = fieldNameSlot(hashFieldName(name.c_str(), name.length()));
+	unsigned i = getFieldNameSlots()[slot];
 	// 0 is reserved for UNKNOWN
-	for(unsigned i = 1; i < HTTP_HEADER_CUSTOM; ++i) {
-		if(name.equalsIgnoreCase(*FieldNameStrings[i - 1]))
-			return static_cast<HttpHeaderFieldName>(i);
+	if(i != 0 && name.equalsIgnoreCase(*FieldNameStrings[i - 1])) {
+		return static_cast<HttpHeaderFieldName>(i);
 	}
 
 	return findCustomFieldName(name);
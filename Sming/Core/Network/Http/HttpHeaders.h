@@ -75,7 +75,9 @@
 	XX(UPGRADE, "Upgrade",                                                                                             \
 	   "Used to transition from HTTP to some other protocol on the same connection. e.g. Websocket")                   \
 	XX(USER_AGENT, "User-Agent", "Information about the user agent originating the request")                           \
-	XX(WWW_AUTHENTICATE, "WWW-Authenticate", "Indicates HTTP authentication scheme(s) and applicable parameters")
+	XX(WWW_AUTHENTICATE, "WWW-Authenticate", "Indicates HTTP authentication scheme(s) and applicable parameters")      \
+	XX(ACCEPT_ENCODING, "Accept-Encoding", "Content codings acceptable to the user agent, e.g. gzip, br")              \
+	XX(VARY, "Vary", "Request headers used to select between representations of a resource, for caches")
 
 enum HttpHeaderFieldName {
 	HTTP_HEADER_UNKNOWN = 0,
@@ -116,6 +118,20 @@ public:
 		return toString(toString(name), value);
 	}
 
+	/** @brief Get the number of characters required to output all header lines
+	 *  @retval size_t
+	 *  @see appendTo()
+	 */
+	size_t getOutputLength() const;
+
+	/** @brief Append all header lines to a String
+	 *  @param str
+	 *  @retval bool false on memory allocation failure
+	 *  @note Lines are terminated with CRLF. Field names are copied directly from flash
+	 *  and the String is extended at most once, so no intermediate Strings are created.
+	 */
+	bool appendTo(String& str) const;
+
 	/** @brief Find the enumerated value for the given field name string
 	 *  @param name
 	 *  @retval HttpHeaderFieldName field name code, HTTP_HEADER_UNKNOWN if not recognised
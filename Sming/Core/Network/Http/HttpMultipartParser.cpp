@@ -0,0 +1,330 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * HttpMultipartParser.cpp
+ *
+ ****/
+
+#include "HttpBodyParser.h"
+
+#define MULTIPART_BOUNDARY_MAX 70 // RFC 2046
+
+/*
+ * Content is scanned for the delimiter ("\r\n--" followed by the boundary) a character at a time.
+ * Part data is passed on in runs taken directly from the received buffer. Only a delimiter partially
+ * matched at the end of a chunk is held back; as that's a prefix of the delimiter it needn't be stored.
+ *
+ * Boundaries cannot contain CR so on a mismatch the only possible restart is at the current character.
+ */
+class MultipartParser
+{
+public:
+	bool begin(const String& contentType);
+
+	/**
+	 * @brief Process a chunk of body content
+	 * @retval size_t Number of bytes processed, less than length on error
+	 */
+	size_t execute(HttpRequest& request, const char* at, size_t length);
+
+	bool isComplete() const
+	{
+		return state == eMPS_Epilogue;
+	}
+
+private:
+	enum State {
+		eMPS_Preamble, ///< Content before first delimiter, ignored
+		eMPS_Boundary, ///< Following a delimiter, expecting CRLF or "--"
+		eMPS_Headers,
+		eMPS_Data,
+		eMPS_Epilogue, ///< Content after final delimiter, ignored
+	};
+
+	void parseHeader();
+	void beginPart(HttpRequest& request);
+	bool partData(const char* data, size_t length);
+	void endPart(HttpRequest& request);
+
+	State state = eMPS_Preamble;
+	char delimiter[4 + MULTIPART_BOUNDARY_MAX];
+	uint8_t delimiterLength = 0;
+	uint8_t matchPos = 0;
+	uint8_t dashCount = 0;
+	uint16_t headerLength = 0;
+	char header[HTTP_MULTIPART_HEADER_SIZE];
+	String partName;
+	String partValue;
+	ReadWriteStream* partStream = nullptr;
+	bool partIsFile = false;
+	bool partOverflow = false;
+	bool headerOverflow = false;
+	bool partDiscard = false; ///< Part has a header which was too long
+};
+
+/*
+ * Find a parameter in a header such as `form-data; name="field"; filename="file.txt"`
+ */
+static bool getHeaderParameter(const char* header, const char* name, String& value)
+{
+	size_t nameLength = strlen(name);
+	for(auto p = strchr(header, ';'); p != nullptr; p = strchr(p, ';')) {
+		++p;
+		while(*p == ' ' || *p == '\t') {
+			++p;
+		}
+		if(strncasecmp(p, name, nameLength) != 0 || p[nameLength] != '=') {
+			continue;
+		}
+
+		p += nameLength + 1;
+		const char* end;
+		if(*p == '"') {
+			++p;
+			end = strchr(p, '"');
+		} else {
+			end = strchr(p, ';');
+		}
+		value.setString(p, (end == nullptr) ? strlen(p) : (end - p));
+		if(*(p - 1) != '"') {
+			value.trim();
+		}
+		return true;
+	}
+
+	return false;
+}
+
+bool MultipartParser::begin(const String& contentType)
+{
+	String boundary;
+	if(!getHeaderParameter(contentType.c_str(), "boundary", boundary)) {
+		return false;
+	}
+
+	if(boundary.length() == 0 || boundary.length() > MULTIPART_BOUNDARY_MAX) {
+		return false;
+	}
+
+	memcpy(delimiter, "\r\n--", 4);
+	memcpy(&delimiter[4], boundary.c_str(), boundary.length());
+	delimiterLength = 4 + boundary.length();
+
+	// The first delimiter usually starts the body, so treat it as though preceded by CRLF
+	state = eMPS_Preamble;
+	matchPos = 2;
+	return true;
+}
+
+size_t MultipartParser::execute(HttpRequest& request, const char* at, size_t length)
+{
+	// Delimiter characters matched in a previous chunk, held back
+	uint8_t carry = matchPos;
+	// Start of part data in this chunk
+	size_t runStart = 0;
+
+	size_t i = 0;
+	while(i < length) {
+		char c = at[i++];
+		switch(state) {
+		case eMPS_Preamble:
+		case eMPS_Data:
+			if(c == delimiter[matchPos]) {
+				if(++matchPos < delimiterLength) {
+					break;
+				}
+
+				// Delimiter complete: part data ends where it started, held back characters are discarded
+				if(state == eMPS_Data) {
+					size_t runEnd = i - (delimiterLength - carry);
+					if(runEnd > runStart && !partData(&at[runStart], runEnd - runStart)) {
+						return runStart;
+					}
+					endPart(request);
+				}
+				state = eMPS_Boundary;
+				dashCount = 0;
+				matchPos = 0;
+				carry = 0;
+			} else if(matchPos != 0) {
+				// Characters held back from the previous chunk turned out to be data, and precede this run
+				if(carry != 0) {
+					if(state == eMPS_Data && !partData(delimiter, carry)) {
+						return 0;
+					}
+					carry = 0;
+				}
+				matchPos = (c == delimiter[0]) ? 1 : 0;
+			}
+			break;
+
+		case eMPS_Boundary:
+			if(c == '-') {
+				if(++dashCount == 2) {
+					state = eMPS_Epilogue;
+				}
+			} else if(c == '\n') {
+				state = eMPS_Headers;
+				headerLength = 0;
+				headerOverflow = false;
+				partName = nullptr;
+				partIsFile = false;
+				partDiscard = false;
+			}
+			// Ignore CR and transport padding
+			break;
+
+		case eMPS_Headers:
+			if(c != '\n') {
+				if(headerLength < sizeof(header) - 1) {
+					header[headerLength++] = c;
+				} else if(c != '\r') {
+					headerOverflow = true;
+				}
+				break;
+			}
+
+			if(headerLength != 0 && header[headerLength - 1] == '\r') {
+				--headerLength;
+			}
+			if(headerLength != 0) {
+				if(headerOverflow) {
+					// A truncated header could give the wrong field name
+					partDiscard = true;
+					headerOverflow = false;
+				} else {
+					parseHeader();
+				}
+				headerLength = 0;
+				break;
+			}
+
+			// Blank line ends headers
+			beginPart(request);
+			state = eMPS_Data;
+			runStart = i;
+			matchPos = 0;
+			carry = 0;
+			break;
+
+		case eMPS_Epilogue:
+			i = length;
+			break;
+		}
+	}
+
+	// Pass on data up to any partially matched delimiter
+	if(state == eMPS_Data) {
+		size_t runEnd = length - (matchPos - carry);
+		if(runEnd > runStart && !partData(&at[runStart], runEnd - runStart)) {
+			return runStart;
+		}
+	}
+
+	return length;
+}
+
+void MultipartParser::parseHeader()
+{
+	header[headerLength] = '\0';
+	if(strncasecmp(header, _F("Content-Disposition:"), 20) != 0) {
+		return;
+	}
+
+	getHeaderParameter(header, "name", partName);
+	String filename;
+	partIsFile = getHeaderParameter(header, "filename", filename);
+}
+
+void MultipartParser::beginPart(HttpRequest& request)
+{
+	if(partDiscard) {
+		debug_w("Multipart: Header too long, part discarded");
+		partName = nullptr;
+		partIsFile = false;
+	}
+
+	partStream = (partName.length() != 0) ? request.uploads.find(partName) : nullptr;
+	partValue.setLength(0);
+	partOverflow = false;
+
+	if(partStream == nullptr && partIsFile) {
+		debug_w("Multipart: No stream for file '%s', discarded", partName.c_str());
+	}
+}
+
+bool MultipartParser::partData(const char* data, size_t length)
+{
+	if(partStream != nullptr) {
+		if(partStream->write(reinterpret_cast<const uint8_t*>(data), length) != length) {
+			debug_e("Multipart: Failed to write '%s'", partName.c_str());
+			return false;
+		}
+		return true;
+	}
+
+	if(partIsFile || partName.length() == 0) {
+		return true;
+	}
+
+	if(partOverflow || partValue.length() + length > HTTP_FORM_BUFFER_SIZE) {
+		partOverflow = true;
+	} else {
+		partValue.concat(data, length);
+	}
+
+	return true;
+}
+
+void MultipartParser::endPart(HttpRequest& request)
+{
+	if(partStream != nullptr || partIsFile || partName.length() == 0) {
+		partStream = nullptr;
+		return;
+	}
+
+	auto& params = request.postParams;
+	if(partOverflow) {
+		debug_w("Form field '%s' too long, discarded", partName.c_str());
+	} else if(params.count() < HTTP_FORM_MAX_FIELDS || params.contains(partName)) {
+		params[partName] = partValue;
+	} else {
+		debug_w("Too many form fields, '%s' discarded", partName.c_str());
+	}
+}
+
+size_t formMultipartParser(HttpRequest& request, const char* at, int length)
+{
+	auto parser = static_cast<MultipartParser*>(request.args);
+
+	if(length == PARSE_DATASTART) {
+		delete parser;
+		parser = new MultipartParser;
+		if(!parser->begin(request.headers[HTTP_HEADER_CONTENT_TYPE])) {
+			debug_e("Multipart: Invalid boundary");
+			delete parser;
+			parser = nullptr;
+		}
+		request.args = parser;
+		return 0;
+	}
+
+	if(parser == nullptr) {
+		debug_e("Invalid request argument");
+		return 0;
+	}
+
+	if(length == PARSE_DATAEND) {
+		if(!parser->isComplete()) {
+			debug_w("Multipart: Content incomplete");
+		}
+		delete parser;
+		request.args = nullptr;
+		return 0;
+	}
+
+	return parser->execute(request, at, length);
+}
@@ -15,6 +15,7 @@
 
 HttpRequest::HttpRequest(const HttpRequest& value)
 	: uri(value.uri), method(value.method), headers(value.headers), postParams(value.postParams),
+	  pathParams(value.pathParams),
 	  headersCompletedDelegate(value.headersCompletedDelegate), requestBodyDelegate(value.requestBodyDelegate),
 	  requestCompletedDelegate(value.requestCompletedDelegate)
 #ifdef ENABLE_SSL
@@ -96,7 +97,9 @@ void HttpRequest::reset()
 	responseStream = nullptr;
 
 	postParams.clear();
+	pathParams.clear();
 	files.clear();
+	uploads.clear();
 }
 
 #ifndef SMING_RELEASE
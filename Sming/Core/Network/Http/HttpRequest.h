@@ -18,6 +18,7 @@
 #endif
 #include "../TcpConnection.h"
 #include "Data/Stream/DataSourceStream.h"
+#include "Data/Stream/ReadWriteStream.h"
 #include "Data/Stream/MultipartStream.h"
 #include "HttpHeaders.h"
 #include "HttpParams.h"
@@ -147,6 +148,16 @@ public:
 		return static_cast<const HttpParams&>(postParams)[name];
 	}
 
+	/**
+	 * @brief Get the value of a parameterised path segment
+	 * @param name Parameter name, as given in the resource path, e.g. `id` for `/api/device/{id}`
+	 * @retval const String& Empty if parameter not present
+	 */
+	const String& getPathParameter(const String& name)
+	{
+		return static_cast<const HttpParams&>(pathParams)[name];
+	}
+
 	/** @deprecated Use `uri.Path` instead */
 	String getPath() SMING_DEPRECATED
 	{
@@ -277,6 +288,14 @@ public:
 	HttpMethod method = HTTP_GET;
 	HttpHeaders headers;
 	HttpParams postParams;
+	HttpParams pathParams; ///< Values for parameterised segments of resource path
+
+	/**
+	 * @brief Destination streams for incoming file uploads, keyed by form field name
+	 * @note Used by `formMultipartParser()`. Set these in the resource `onHeadersComplete` handler;
+	 * they are owned by the request and deleted when it completes.
+	 */
+	ObjectMap<String, ReadWriteStream> uploads;
 
 	int retries = 0; // how many times the request should be send again...
 
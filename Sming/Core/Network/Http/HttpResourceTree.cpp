@@ -42,3 +42,166 @@ void HttpResourceTree::set(String path, const HttpPathDelegate& callback)
 
 	set(path, new HttpCompatResource(callback));
 }
+
+/*
+ * Each node represents one path segment. Children are the possible next segments, linked as a list
+ * of siblings; these are typically few so a simple list is more compact and faster than a table.
+ */
+struct HttpResourceTree::Node {
+	enum class Type : uint8_t {
+		literal,
+		param,
+		wildcard,
+	};
+
+	Node* next = nullptr;	 ///< Next sibling
+	Node* children = nullptr; ///< First child
+	String name;			  ///< Literal segment text or parameter name
+	int index = -1;			  ///< Map entry index if a path ends here
+	Type type;
+
+	Node(Type type, const char* name, unsigned length) : name(name, length), type(type)
+	{
+	}
+
+	~Node()
+	{
+		// Deleting the siblings iteratively keeps recursion depth to the number of path segments
+		while(children != nullptr) {
+			auto child = children;
+			children = child->next;
+			child->next = nullptr;
+			delete child;
+		}
+	}
+
+	void add(const char* path, int entryIndex);
+
+	static int find(const Node* list, const char* path, HttpParams* params);
+};
+
+void HttpResourceTree::Node::add(const char* path, int entryIndex)
+{
+	auto node = this;
+	for(;;) {
+		auto sep = strchr(path, '/');
+		unsigned len = (sep == nullptr) ? strlen(path) : sep - path;
+
+		Type type = Type::literal;
+		const char* name = path;
+		unsigned nameLength = len;
+		if(len == 1 && path[0] == '*') {
+			type = Type::wildcard;
+			nameLength = 0;
+		} else if(len >= 2 && path[0] == '{' && path[len - 1] == '}') {
+			type = Type::param;
+			++name;
+			nameLength -= 2;
+		}
+
+		// Find existing child, or add a new one at the end of the list
+		Node** link = &node->children;
+		while(*link != nullptr) {
+			auto child = *link;
+			if(child->type == type && child->name.length() == nameLength &&
+			   memcmp(child->name.c_str(), name, nameLength) == 0) {
+				break;
+			}
+			link = &child->next;
+		}
+		if(*link == nullptr) {
+			*link = new Node(type, name, nameLength);
+		}
+		node = *link;
+
+		if(sep == nullptr) {
+			node->index = entryIndex;
+			return;
+		}
+		path = sep + 1;
+	}
+}
+
+int HttpResourceTree::Node::find(const Node* list, const char* path, HttpParams* params)
+{
+	auto sep = strchr(path, '/');
+	unsigned len = (sep == nullptr) ? strlen(path) : sep - path;
+
+	auto descend = [&](const Node* node) -> int {
+		return (sep == nullptr) ? node->index : find(node->children, sep + 1, params);
+	};
+
+	// Literal segments take priority
+	for(auto node = list; node != nullptr; node = node->next) {
+		if(node->type == Type::literal && node->name.length() == len && memcmp(node->name.c_str(), path, len) == 0) {
+			int index = descend(node);
+			if(index >= 0) {
+				return index;
+			}
+		}
+	}
+
+	for(auto node = list; node != nullptr; node = node->next) {
+		if(node->type != Type::param) {
+			continue;
+		}
+		int index = descend(node);
+		if(index >= 0) {
+			if(params != nullptr) {
+				(*params)[node->name] = String(path, len);
+			}
+			return index;
+		}
+	}
+
+	for(auto node = list; node != nullptr; node = node->next) {
+		if(node->type != Type::wildcard) {
+			continue;
+		}
+		int index = descend(node);
+		if(index >= 0) {
+			return index;
+		}
+		// Trailing wildcard matches everything which remains
+		if(node->children == nullptr && node->index >= 0) {
+			return node->index;
+		}
+	}
+
+	return -1;
+}
+
+void HttpResourceTree::invalidate()
+{
+	delete root;
+	root = nullptr;
+}
+
+void HttpResourceTree::build()
+{
+	invalidate();
+	root = new Node(Node::Type::literal, nullptr, 0);
+	rootGeneration = generation;
+	for(unsigned i = 0; i < count(); ++i) {
+		const String& path = keyAt(i);
+		if(path == RESOURCE_PATH_DEFAULT) {
+			continue;
+		}
+		root->add(path.c_str() + (path[0] == '/' ? 1 : 0), i);
+	}
+}
+
+HttpResource* HttpResourceTree::match(const String& path, HttpParams* params)
+{
+	// Index is rebuilt if entries have been added or removed, as indices may have changed
+	if(root == nullptr || rootGeneration != generation) {
+		build();
+	}
+
+	if(path.length() == 0) {
+		return nullptr;
+	}
+
+	int index = Node::find(root->children, path.c_str() + (path[0] == '/' ? 1 : 0), params);
+	return (index < 0) ? nullptr : entries[index].value;
+}
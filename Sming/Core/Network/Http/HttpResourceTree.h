@@ -20,10 +20,26 @@ typedef Delegate<void(HttpRequest& request, HttpResponse& response)> HttpPathDel
 #define RESOURCE_PATH_DEFAULT String('*')
 
 /** @brief Class to map URL paths to classes which handle them
+ *  @note Paths may contain parameterised and wildcard segments:
+ *
+ *  	/api/device/{id}		Matches `/api/device/12`, with path parameter `id` = "12"
+ *  	/api/{type}/status		Matches `/api/sensor/status`, with path parameter `type` = "sensor"
+ *
+ *  A `*` segment matches any single segment or, if it's the last one, the remainder of the path.
+ *  So a path of `/files` followed by `/` and `*` matches `/files/` and everything below it.
+ *  Literal segments take priority over parameters, which take priority over wildcards.
+ *
+ *  Paths are indexed using a segment trie, built on first use after the set of paths is changed,
+ *  so lookup cost depends on the length of the request path rather than the number of paths registered.
  */
 class HttpResourceTree : public ObjectMap<String, HttpResource>
 {
 public:
+	~HttpResourceTree()
+	{
+		invalidate();
+	}
+
 	/** @brief Set the default resource handler
 	 *  @param resource The default resource handler
 	 */
@@ -78,4 +94,21 @@ public:
 	 * @note Any existing handler for this path is replaced
 	 */
 	void set(String path, const HttpPathDelegate& callback);
+
+	/**
+	 * @brief Find the resource to handle a request path
+	 * @param path The request path, e.g. `/api/device/12`
+	 * @param params If provided, values for parameterised segments are stored here
+	 * @retval HttpResource* nullptr if there's no match; the default resource is not considered
+	 */
+	HttpResource* match(const String& path, HttpParams* params = nullptr);
+
+private:
+	struct Node;
+
+	void invalidate();
+	void build();
+
+	Node* root = nullptr;		 ///< Index of paths, created on demand
+	unsigned rootGeneration = 0; ///< Map generation when index was built
 };
@@ -66,21 +66,224 @@ bool HttpResponse::sendString(const String& text)
 	return buffer->print(text) == text.length();
 }
 
+/*
+ * Content codings supported for file variants, in order of preference
+ */
+#define FILE_ENCODING_MAP(XX)                                                                                          \
+	XX(BROTLI, "br", ".br")                                                                                            \
+	XX(GZIP, "gzip", ".gz")                                                                                            \
+	XX(IDENTITY, "identity", "")
+
+enum FileEncoding {
+#define XX(_tag, _name, _ext) FILE_ENCODING_##_tag,
+	FILE_ENCODING_MAP(XX)
+#undef XX
+		FILE_ENCODING_MAX
+};
+
+#define FILE_ENCODING_BIT(_tag) (1U << FILE_ENCODING_##_tag)
+#define FILE_ENCODING_ALL ((1U << FILE_ENCODING_MAX) - 1)
+
+static const char* const fileEncodingNames[] = {
+#define XX(_tag, _name, _ext) _name,
+	FILE_ENCODING_MAP(XX)
+#undef XX
+};
+
+static const char* const fileEncodingExtensions[] = {
+#define XX(_tag, _name, _ext) _ext,
+	FILE_ENCODING_MAP(XX)
+#undef XX
+};
+
+/*
+ * Record which variants exist for recently requested files. Each path maps to one slot, by hash,
+ * so a lookup needs just one comparison.
+ */
+#ifndef HTTP_FILE_CACHE_SIZE
+#define HTTP_FILE_CACHE_SIZE 16
+#endif
+
+struct FileCacheEntry {
+	String path;
+	uint8_t variants; ///< Bitmask of FileEncoding values
+};
+
+static FileCacheEntry fileCache[HTTP_FILE_CACHE_SIZE];
+
+void HttpResponse::clearFileCache()
+{
+	for(auto& entry : fileCache) {
+		entry.path = nullptr;
+	}
+}
+
+static uint8_t getFileVariants(const String& fileName)
+{
+	uint32_t hash = 2166136261U;
+	for(unsigned i = 0; i < fileName.length(); ++i) {
+		hash = (hash ^ uint8_t(fileName[i])) * 16777619U;
+	}
+
+	auto& entry = fileCache[hash % HTTP_FILE_CACHE_SIZE];
+	if(entry.path.length() != 0 && entry.path == fileName) {
+		return entry.variants;
+	}
+
+	uint8_t variants = 0;
+	for(unsigned i = 0; i < FILE_ENCODING_MAX; ++i) {
+		if(fileExist(fileName + fileEncodingExtensions[i])) {
+			variants |= 1U << i;
+		}
+	}
+
+	// Don't cache misses, the file may yet be created
+	if(variants != 0) {
+		entry.path = fileName;
+		entry.variants = variants;
+	}
+	return variants;
+}
+
+/*
+ * A quality value of zero may be written as "0", "0.", "0.0", etc. up to three decimal places (RFC 7231 5.3.1).
+ */
+static bool isZeroQuality(const char* q)
+{
+	if(*q++ != '0') {
+		return false;
+	}
+	if(*q == '.') {
+		do {
+			++q;
+		} while(*q == '0');
+	}
+	return *q == '\0' || *q == ';' || isspace(*q);
+}
+
+/*
+ * Determine acceptable encodings from request headers.
+ * Quality values are only checked for zero, which indicates the coding is not acceptable;
+ * otherwise the server order of preference is used.
+ */
+static uint8_t getAcceptedEncodings(const HttpHeaders* requestHeaders)
+{
+	if(requestHeaders == nullptr || !requestHeaders->contains(HTTP_HEADER_ACCEPT_ENCODING)) {
+		// Any coding is acceptable (RFC 7231 5.3.4), but stick with gzip as it's universally supported
+		return FILE_ENCODING_BIT(GZIP) | FILE_ENCODING_BIT(IDENTITY);
+	}
+
+	uint8_t accepted = 0;
+	uint8_t rejected = 0;
+	bool wildcard = false;
+	bool wildcardAcceptable = false;
+	const String& value = (*requestHeaders)[HTTP_HEADER_ACCEPT_ENCODING];
+	const char* p = value.c_str();
+	while(*p != '\0') {
+		auto end = strchr(p, ',');
+		unsigned len = (end == nullptr) ? strlen(p) : end - p;
+		String coding(p, len);
+		p += len;
+		if(*p == ',') {
+			++p;
+		}
+
+		bool acceptable = true;
+		int sep = coding.indexOf(';');
+		if(sep >= 0) {
+			auto q = strstr(coding.c_str() + sep, "q=");
+			if(q != nullptr) {
+				acceptable = !isZeroQuality(q + 2);
+			}
+			coding.setLength(sep);
+		}
+		coding.trim();
+
+		if(coding == "*") {
+			wildcard = true;
+			wildcardAcceptable = acceptable;
+			continue;
+		}
+
+		for(unsigned i = 0; i < FILE_ENCODING_MAX; ++i) {
+			if(coding.equalsIgnoreCase(fileEncodingNames[i])) {
+				(acceptable ? accepted : rejected) |= 1U << i;
+				break;
+			}
+		}
+	}
+
+	// Wildcard applies to any codings not explicitly listed
+	if(wildcard) {
+		uint8_t others = FILE_ENCODING_ALL & ~(accepted | rejected);
+		(wildcardAcceptable ? accepted : rejected) |= others;
+	}
+
+	// Identity is acceptable unless explicitly excluded
+	accepted |= FILE_ENCODING_BIT(IDENTITY) & ~rejected;
+	return accepted;
+}
+
 bool HttpResponse::sendFile(String fileName, bool allowGzipFileCheck)
 {
-	String compressed = fileName + ".gz";
-	if(allowGzipFileCheck && fileExist(compressed)) {
-		debug_d("found %s", compressed.c_str());
-		setStream(new FileStream(compressed));
-		headers[HTTP_HEADER_CONTENT_ENCODING] = _F("gzip");
-	} else if(fileExist(fileName)) {
-		debug_d("found %s", fileName.c_str());
-		setStream(new FileStream(fileName));
+	uint8_t variants;
+	if(allowGzipFileCheck) {
+		variants = getFileVariants(fileName);
 	} else {
+		// Compressed variants aren't wanted so don't look for them
+		variants = fileExist(fileName) ? FILE_ENCODING_BIT(IDENTITY) : 0;
+	}
+
+	if(variants == 0) {
+		setStream(nullptr);
+		code = HTTP_STATUS_NOT_FOUND;
+		return false;
+	}
+
+	// Representation depends on request if there's a choice to be made
+	bool negotiated = (variants != FILE_ENCODING_BIT(IDENTITY));
+	if(negotiated) {
+		headers[HTTP_HEADER_VARY] = _F("Accept-Encoding");
+	}
+
+	uint8_t usable = variants & getAcceptedEncodings(requestHeaders);
+	if(usable == 0) {
+		debug_d("No acceptable encoding for %s", fileName.c_str());
+		setStream(nullptr);
+		code = HTTP_STATUS_NOT_ACCEPTABLE;
+		return false;
+	}
+
+	unsigned encoding = 0;
+	while((usable & (1U << encoding)) == 0) {
+		++encoding;
+	}
+
+	auto fileStream = new FileStream(fileName + fileEncodingExtensions[encoding]);
+	if(!fileStream->isValid()) {
+		// File has been removed since cache entry was made
+		delete fileStream;
+		clearFileCache();
 		setStream(nullptr);
 		code = HTTP_STATUS_NOT_FOUND;
 		return false;
 	}
+	debug_d("found %s", fileStream->getName().c_str());
+	setStream(fileStream);
+
+	if(encoding != FILE_ENCODING_IDENTITY) {
+		headers[HTTP_HEADER_CONTENT_ENCODING] = fileEncodingNames[encoding];
+	}
+
+#ifndef DISABLE_HTTPSRV_ETAG
+	// Each variant requires a distinct entity tag
+	if(negotiated && !headers.contains(HTTP_HEADER_ETAG)) {
+		String tag = fileStream->id();
+		if(tag.length() != 0) {
+			headers[HTTP_HEADER_ETAG] = '"' + tag + '-' + fileEncodingNames[encoding] + '"';
+		}
+	}
+#endif
 
 	if(!headers.contains(HTTP_HEADER_CONTENT_TYPE)) {
 		String mime = ContentType::fromFullFileName(fileName);
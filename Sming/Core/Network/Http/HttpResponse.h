@@ -73,11 +73,24 @@ public:
 	/**
 	 * @brief Send file by name
 	 * @param fileName
-	 * @param allowGzipFileCheck If true, check file extension to see if content commpressed
+	 * @param allowGzipFileCheck If true, look for compressed variants of the file
 	 * @retval bool
+	 * @note Compressed variants are stored with `.gz` (gzip) or `.br` (brotli) appended to the file name.
+	 * The preferred variant acceptable to the client (see `requestHeaders`) is sent, with `Vary` and
+	 * `ETag` headers set accordingly. If only compressed variants exist and the client accepts none of them,
+	 * the response code is set to HTTP_STATUS_NOT_ACCEPTABLE.
+	 *
+	 * Which variants exist is cached for recently requested files, so only one filing system lookup is
+	 * required per request. Missing files are not cached. Call `clearFileCache()` if files are removed or
+	 * compressed variants are added.
 	 */
 	bool sendFile(String fileName, bool allowGzipFileCheck = true);
 
+	/**
+	 * @brief Discard cached information about which files and compressed variants exist
+	 */
+	static void clearFileCache();
+
 	/**
 	 * @brief Parse and send template file
 	 * @param newTemplateInstance
@@ -140,6 +153,7 @@ private:
 public:
 	unsigned code = HTTP_STATUS_OK; ///< The HTTP status response code
 	HttpHeaders headers;
+	const HttpHeaders* requestHeaders = nullptr; ///< Set by server for content negotiation, may be null
 	ReadWriteStream* buffer = nullptr;   ///< Internal stream for storing strings and receiving responses
 	IDataSourceStream* stream = nullptr; ///< The body stream
 };
@@ -16,6 +16,30 @@
 #include "Network/TcpServer.h"
 #include "Network/WebConstants.h"
 #include "Data/Stream/ChunkedStream.h"
+#include "Services/Profiling/EventProfiler.h"
+
+MemoryPool HttpServerConnection::pool;
+
+bool HttpServerConnection::reservePool(unsigned count)
+{
+	if(pool.capacity() >= count) {
+		return true;
+	}
+
+	return pool.initialise(sizeof(HttpServerConnection), count);
+}
+
+void* HttpServerConnection::operator new(size_t size)
+{
+	return pool.allocate(size) ?: ::operator new(size);
+}
+
+void HttpServerConnection::operator delete(void* ptr)
+{
+	if(!pool.release(ptr)) {
+		::operator delete(ptr);
+	}
+}
 
 int HttpServerConnection::onMessageBegin(http_parser* parser)
 {
@@ -42,7 +66,7 @@ int HttpServerConnection::onPath(const Url& uri)
 
 	request.setURL(uri);
 
-	resource = resourceTree->find(request.uri.Path);
+	resource = resourceTree->match(request.uri.Path, &request.pathParams);
 	if(resource == nullptr) {
 		resource = resourceTree->getDefault();
 	}
@@ -64,6 +88,7 @@ int HttpServerConnection::onMessageComplete(http_parser* parser)
 	}
 
 	if(resource != nullptr && resource->onRequestComplete) {
+		PROFILE_EVENT(HTTP_HANDLER, resource);
 		hasError = resource->onRequestComplete(*this, request, response);
 	}
 
@@ -74,9 +99,55 @@ int HttpServerConnection::onMessageComplete(http_parser* parser)
 		request.responseStream = nullptr;
 	}
 
+	/*
+	 * If the response hasn't been sent in its entirety then any further (pipelined) requests
+	 * must wait, so pause the parser. Unparsed data is queued via onParserPaused().
+	 */
+	if(state != eHCS_Ready) {
+		http_parser_pause(parser, 1);
+	}
+
 	return hasError;
 }
 
+bool HttpServerConnection::onParserPaused(char* data, int size)
+{
+	if(pipeline.length() + size > HTTP_SERVER_PIPELINE_SIZE) {
+		debug_w("HttpServerConnection: Pipeline full, aborting connection");
+		return false;
+	}
+
+	if(size > 0) {
+		pipeline.concat(data, size);
+	}
+	return true;
+}
+
+void HttpServerConnection::processPipeline()
+{
+	// Parsing may complete another request and so get here again; the loop below handles that
+	if(processingPipeline) {
+		return;
+	}
+
+	processingPipeline = true;
+	while(state == eHCS_Ready && HTTP_PARSER_ERRNO(&parser) == HPE_PAUSED) {
+		http_parser_pause(&parser, 0);
+		if(pipeline.length() == 0) {
+			break;
+		}
+
+		// Parser may pause again, in which case the remainder gets queued
+		String data = std::move(pipeline);
+		if(!onTcpReceive(*this, data.begin(), data.length())) {
+			pipeline = nullptr;
+			setTimeOut(1);
+			break;
+		}
+	}
+	processingPipeline = false;
+}
+
 int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 {
 	/* Callbacks should return non-zero to indicate an error. The parser will
@@ -97,6 +168,7 @@ int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 	request.setHeaders(headers);
 
 	if(resource != nullptr && resource->onHeadersComplete) {
+		PROFILE_EVENT(HTTP_HANDLER, resource);
 		error = resource->onHeadersComplete(*this, request, response);
 	}
 
@@ -142,10 +214,15 @@ int HttpServerConnection::onHeadersComplete(const HttpHeaders& headers)
 int HttpServerConnection::onBody(const char* at, size_t length)
 {
 	if(bodyParser) {
-		bodyParser(request, at, length);
+		size_t consumed = bodyParser(request, at, length);
+		if(consumed != length) {
+			debug_e("HttpServerConnection: Body parser failed after %u of %u bytes", consumed, length);
+			return -1;
+		}
 	}
 
 	if(resource != nullptr && resource->onBody) {
+		PROFILE_EVENT(HTTP_HANDLER, resource);
 		return resource->onBody(*this, request, at, length);
 	}
 
@@ -162,7 +239,12 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 {
 	switch(state) {
 	case eHCS_StartSending: {
-		sendResponseHeaders(&response);
+		if(!sendResponseHeaders(&response)) {
+			// Response cannot be sent, so discard any pipelined requests and close on next poll
+			pipeline = nullptr;
+			setTimeOut(1);
+			break;
+		}
 		state = eHCS_SendingHeaders;
 	}
 
@@ -180,14 +262,15 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 			break;
 		}
 
-		delete stream;
-		stream = nullptr;
+		releaseStream(stream);
 		state = eHCS_Sent;
 	}
 
 	case eHCS_Sent: {
 		if(response.headers[HTTP_HEADER_CONNECTION] == _F("close")) {
 			setTimeOut(1); // decrease the timeout to 1 tick
+			// Discard any pipelined requests
+			pipeline = nullptr;
 		}
 
 		response.reset();
@@ -203,9 +286,13 @@ void HttpServerConnection::onReadyToSendData(TcpConnectionEvent sourceEvent)
 	} /* switch(state) */
 
 	TcpClient::onReadyToSendData(sourceEvent);
+
+	if(state == eHCS_Ready) {
+		processPipeline();
+	}
 }
 
-void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
+bool HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 {
 #ifndef DISABLE_HTTPSRV_ETAG
 	if(response->stream != nullptr && !response->headers.contains(HTTP_HEADER_ETAG)) {
@@ -225,9 +312,6 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 		}
 	}
 #endif /* DISABLE_HTTPSRV_ETAG */
-	String statusLine =
-		F("HTTP/1.1 ") + String(response->code) + ' ' + httpGetStatusText((enum http_status)response->code) + "\r\n";
-	sendString(statusLine);
 	if(response->stream != nullptr && response->stream->available() >= 0) {
 		response->headers[HTTP_HEADER_CONTENT_LENGTH] = String(response->stream->available());
 	}
@@ -251,10 +335,25 @@ void HttpServerConnection::sendResponseHeaders(HttpResponse* response)
 #if HTTP_SERVER_EXPOSE_DATE == 1
 	response->headers[HTTP_HEADER_DATE] = SystemClock.getSystemTimeString();
 #endif
-	for(unsigned i = 0; i < response->headers.count(); i++) {
-		sendString(response->headers[i]);
+
+	/*
+	 * Serialise status line and headers into a single buffer, sized in advance.
+	 * This avoids creating a String for each header and allows them to be sent as one segment.
+	 */
+	String statusText = httpGetStatusText(response->code);
+	String header;
+	if(!header.reserve(9 + 3 + 1 + statusText.length() + 2 + response->headers.getOutputLength() + 2)) {
+		debug_e("HttpServerConnection: Out of memory for response headers");
+		return false;
 	}
-	sendString("\r\n");
+	header += _F("HTTP/1.1 ");
+	header += response->code;
+	header += ' ';
+	header += statusText;
+	header.concat("\r\n", 2);
+	response->headers.appendTo(header);
+	header.concat("\r\n", 2);
+	return sendString(header);
 }
 
 bool HttpServerConnection::sendResponseBody(HttpResponse* response)
@@ -273,7 +372,7 @@ bool HttpServerConnection::sendResponseBody(HttpResponse* response)
 			return true;
 		}
 
-		delete stream;
+		releaseStream(stream);
 		if(response->headers[HTTP_HEADER_TRANSFER_ENCODING] == _F("chunked")) {
 			stream = new ChunkedStream(response->stream);
 		} else {
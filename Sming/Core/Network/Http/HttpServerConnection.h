@@ -15,6 +15,7 @@
 #include "HttpConnection.h"
 #include "HttpResource.h"
 #include "HttpBodyParser.h"
+#include "Data/MemoryPool.h"
 
 #include <functional>
 
@@ -32,6 +33,14 @@
 #define HTTP_SERVER_EXPOSE_DATE 0
 #endif
 
+/*
+ * Maximum number of bytes to queue for pipelined requests, received whilst a response is being sent.
+ * If exceeded, the connection is aborted.
+ */
+#ifndef HTTP_SERVER_PIPELINE_SIZE
+#define HTTP_SERVER_PIPELINE_SIZE 2048
+#endif
+
 class HttpResourceTree;
 class HttpServerConnection;
 
@@ -44,6 +53,7 @@ class HttpServerConnection : public HttpConnection
 public:
 	HttpServerConnection(tcp_pcb* clientTcp) : HttpConnection(clientTcp, HTTP_REQUEST)
 	{
+		response.requestHeaders = &request.headers;
 	}
 
 	~HttpServerConnection()
@@ -81,6 +91,24 @@ public:
 		return &request;
 	}
 
+	/** @brief Reserve memory for a number of connections
+	 *  @param count Number of connections which may be open simultaneously
+	 *  @retval bool true if the pool has capacity for at least `count` connections
+	 *  @note Connections are allocated from a fixed pool where possible, so repeatedly
+	 *  opening and closing connections does not fragment the heap. If the pool is exhausted,
+	 *  or a derived class is larger, connections are allocated from the heap as normal.
+	 *  The pool can only be enlarged whilst no pooled connections are open.
+	 */
+	static bool reservePool(unsigned count);
+
+	static const MemoryPool& getPool()
+	{
+		return pool;
+	}
+
+	static void* operator new(size_t size);
+	static void operator delete(void* ptr);
+
 protected:
 	// HTTP parser methods
 
@@ -101,18 +129,23 @@ protected:
 
 	void onHttpError(http_errno error) override;
 
+	bool onParserPaused(char* data, int size) override;
+
 	// TCP methods
 	void onReadyToSendData(TcpConnectionEvent sourceEvent) override;
 	virtual void sendError(const String& message = nullptr, enum http_status code = HTTP_STATUS_BAD_REQUEST);
 
 private:
-	void sendResponseHeaders(HttpResponse* response);
+	bool sendResponseHeaders(HttpResponse* response);
 	bool sendResponseBody(HttpResponse* response);
+	void processPipeline();
 
 public:
 	void* userData = nullptr; ///< use to pass user data between requests
 
 private:
+	static MemoryPool pool;
+
 	HttpResourceTree* resourceTree = nullptr; ///< A reference to the current resource tree - we don't own it
 	HttpResource* resource = nullptr;		  ///< Resource for currently executing path
 
@@ -125,6 +158,9 @@ private:
 
 	const BodyParsers* bodyParsers = nullptr;	///< const reference ensures we cannot modify map, only look stuff up
 	HttpBodyParserDelegate bodyParser = nullptr; ///< Active body parser for this message, if any
+
+	String pipeline;				 ///< Data for pipelined requests, parsed when current response has been sent
+	bool processingPipeline = false; ///< Guards against re-entry whilst processing pipeline
 };
 
 /** @} */
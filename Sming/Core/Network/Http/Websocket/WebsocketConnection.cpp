@@ -12,6 +12,8 @@
 
 #include "Network/WebHelpers/aw-sha1.h"
 #include "Network/WebHelpers/base64.h"
+#include "Data/Stream/SharedMemoryStream.h"
+#include "WebsocketFrameStream.h"
 
 DEFINE_FSTR(WSSTR_CONNECTION, "connection")
 DEFINE_FSTR(WSSTR_UPGRADE, "upgrade")
@@ -182,79 +184,181 @@ void WebsocketConnection::send(const char* message, size_t length, ws_frame_type
 		return;
 	}
 
-	auto bufferLength = length + 1 + 4 + 4;
-	char buffer[bufferLength];
-	size_t outLength = encodeFrame(type, message, length, buffer, bufferLength, isClientConnection);
-	if(outLength != 0) {
-		connection->send(buffer, outLength);
+	/*
+	 * Encode the complete frame into a single stream so it's either queued in full or not at all.
+	 * Queueing the header and payload separately could leave a truncated frame if memory ran out part way.
+	 */
+	auto frame = new SharedMemoryStream(length + WEBSOCKET_MAX_HEADER_SIZE);
+	size_t outLength = 0;
+	if(frame != nullptr && frame->isValid()) {
+		outLength = encodeFrame(type, message, length, frame->getData(), frame->getLength(), isClientConnection);
 	}
+	if(outLength == 0) {
+		debug_e("WS send: unable to encode %u bytes", length);
+		delete frame;
+		return;
+	}
+	frame->setLength(outLength);
+
+	connection->send(frame);
+}
+
+bool WebsocketConnection::send(IDataSourceStream* source, ws_frame_type_t type)
+{
+	if(source == nullptr) {
+		return false;
+	}
+
+	if(connection == nullptr || !activated) {
+		debug_e("WS Connection is not activated yet!");
+		delete source;
+		return false;
+	}
+
+	return connection->send(new WebsocketFrameStream(source, type, isClientConnection));
 }
 
 void WebsocketConnection::broadcast(const char* message, size_t length, ws_frame_type_t type)
 {
+	/*
+	 * Server connections send unmasked frames, so encode the frame once and give each connection
+	 * its own reader over the shared buffer. Client connections require a unique mask per frame.
+	 */
+	SharedMemoryStream* frame = nullptr;
 	for(unsigned i = 0; i < websocketList.count(); i++) {
-		websocketList[i]->send(message, length, type);
+		auto ws = websocketList[i];
+		if(ws->isClientConnection || ws->connection == nullptr || !ws->activated) {
+			ws->send(message, length, type);
+			continue;
+		}
+
+		if(frame == nullptr) {
+			frame = new SharedMemoryStream(length + WEBSOCKET_MAX_HEADER_SIZE);
+			size_t outLength = 0;
+			if(frame != nullptr && frame->isValid()) {
+				outLength = encodeFrame(type, message, length, frame->getData(), frame->getLength(), false);
+			}
+			if(outLength == 0) {
+				debug_e("WS broadcast: unable to encode %u bytes", length);
+				delete frame;
+				return;
+			}
+			frame->setLength(outLength);
+		}
+
+		ws->connection->send(new SharedMemoryStream(*frame));
 	}
+
+	delete frame;
 }
 
-size_t WebsocketConnection::encodeFrame(ws_frame_type_t type, const char* inData, size_t inLength, char* outData,
-										size_t outLength, bool useMask, bool isFin)
+size_t WebsocketConnection::encodeHeader(uint8_t opcode, size_t payloadLength, bool isFin, uint8_t* maskKey,
+										 uint8_t* outData)
 {
-	if(inLength > 0xFFFF) {
-		return 0; // we don't support big payloads yet
+	size_t i = 0;
+	// byte 0
+	outData[i++] = (isFin ? bit(7) : 0) | (opcode & 0x0F);
+
+	// byte 1, plus extended length
+	uint8_t maskBit = (maskKey != nullptr) ? bit(7) : 0;
+	if(payloadLength < 126) {
+		outData[i++] = maskBit | payloadLength;
+	} else if(payloadLength <= 0xFFFF) {
+		outData[i++] = maskBit | 126;
+		outData[i++] = payloadLength >> 8;
+		outData[i++] = payloadLength;
+	} else {
+		outData[i++] = maskBit | 127;
+		uint64_t length = payloadLength;
+		for(int shift = 56; shift >= 0; shift -= 8) {
+			outData[i++] = length >> shift;
+		}
 	}
 
-	int headerLength = 2;
-	uint8_t maskKey[4] = {0x00, 0x00, 0x00, 0x00};
-	if(inLength > 125) {
-		headerLength = 4;
-	}
-	if(useMask) {
-		headerLength += 4; // if present, mask is 4 bytes in header before payload
+	if(maskKey != nullptr) {
+		for(unsigned x = 0; x < 4; x++) {
+			maskKey[x] = os_random();
+			outData[i++] = maskKey[x];
+		}
 	}
 
-	if(headerLength + inLength > outLength) {
-		// not enough memory to store the data
-		return 0;
+	return i;
+}
+
+/*
+ * Masking is applied a machine word at a time: 32 bits on the ESP8266, 64 bits on Host where the
+ * compiler can also vectorise the loop. Words are accessed through a may_alias type as the payload
+ * is just a byte array.
+ */
+#ifdef ARCH_HOST
+typedef uint64_t __attribute__((__may_alias__)) MaskWord;
+#else
+typedef uint32_t __attribute__((__may_alias__)) MaskWord;
+#endif
+
+void WebsocketConnection::maskPayload(uint8_t* data, size_t length, const uint8_t* maskKey, unsigned keyOffset)
+{
+	// Leading bytes up to word alignment
+	unsigned keyPos = keyOffset % 4;
+	while(length != 0 && (uintptr_t(data) % sizeof(MaskWord)) != 0) {
+		*data++ ^= maskKey[keyPos++ % 4];
+		--length;
 	}
 
-	memset(outData, 0, headerLength); //set initial header state to be all zero
+	size_t wordCount = length / sizeof(MaskWord);
+	if(wordCount != 0) {
+		// Replicate key starting at current position; word size is a multiple of 4 so position is unchanged after
+		uint8_t keyBytes[sizeof(MaskWord)];
+		for(unsigned i = 0; i < sizeof(keyBytes); i++) {
+			keyBytes[i] = maskKey[(keyPos + i) % 4];
+		}
+		MaskWord key;
+		memcpy(&key, keyBytes, sizeof(key));
 
-	int i = 0;
-	// byte 0
-	if(isFin) {
-		outData[i] |= bit(7); // set Fin
+		auto words = reinterpret_cast<MaskWord*>(data);
+		for(size_t i = 0; i < wordCount; i++) {
+			words[i] ^= key;
+		}
+		data += wordCount * sizeof(MaskWord);
+		length -= wordCount * sizeof(MaskWord);
 	}
-	outData[i++] |= (uint8_t)type; // set opcode
 
-	// byte 1
-	if(useMask) {
-		outData[i] |= bit(7); // set mask
+	// Trailing bytes
+	while(length != 0) {
+		*data++ ^= maskKey[keyPos++ % 4];
+		--length;
 	}
+}
 
-	if(inLength < 126) {
-		outData[i++] |= inLength;
-	} else {
-		outData[i++] |= 126;
-		outData[i++] = ((inLength >> 8) & 0xFF);
-		outData[i++] = (inLength & 0xFF);
+/*
+ * Unmasks received payload for ws_parser, which may deliver a frame in several pieces.
+ * See Components/.patches/ws_parser.patch
+ */
+extern "C" void ws_parser_unmask(char* data, size_t length, const void* mask, unsigned maskPos)
+{
+	WebsocketConnection::maskPayload(reinterpret_cast<uint8_t*>(data), length, static_cast<const uint8_t*>(mask),
+									 maskPos);
+}
+
+size_t WebsocketConnection::encodeFrame(ws_frame_type_t type, const char* inData, size_t inLength, char* outData,
+										size_t outLength, bool useMask, bool isFin)
+{
+	uint8_t header[WEBSOCKET_MAX_HEADER_SIZE];
+	uint8_t maskKey[4];
+	size_t headerLength = encodeHeader(type, inLength, isFin, useMask ? maskKey : nullptr, header);
+	if(headerLength + inLength > outLength) {
+		// not enough memory to store the data
+		return 0;
 	}
 
+	memcpy(outData, header, headerLength);
+	auto payload = reinterpret_cast<uint8_t*>(outData) + headerLength;
+	memcpy(payload, inData, inLength);
 	if(useMask) {
-		for(uint8_t x = 0; x < sizeof(maskKey); x++) {
-			maskKey[x] = (char)os_random();
-			outData[i++] = maskKey[x];
-		}
-
-		for(size_t x = 0; x < inLength; x++) {
-			outData[i++] = (inData[x] ^ maskKey[x % 4]);
-		}
-	} else {
-		memcpy(&outData[i], inData, inLength);
-		i += inLength;
+		maskPayload(payload, inLength, maskKey);
 	}
 
-	return i;
+	return headerLength + inLength;
 }
 
 void WebsocketConnection::close()
@@ -24,6 +24,14 @@ extern "C" {
 
 #define WEBSOCKET_VERSION 13 // 1.3
 
+/// Largest frame header: 2 bytes, 64-bit extended payload length and mask key
+#define WEBSOCKET_MAX_HEADER_SIZE 14
+
+/// Payload size of each fragment when sending a stream
+#ifndef WEBSOCKET_FRAGMENT_SIZE
+#define WEBSOCKET_FRAGMENT_SIZE 1024
+#endif
+
 DECLARE_FSTR(WSSTR_CONNECTION)
 DECLARE_FSTR(WSSTR_UPGRADE)
 DECLARE_FSTR(WSSTR_WEBSOCKET)
@@ -100,11 +108,23 @@ public:
 		send(message.c_str(), message.length(), type);
 	}
 
+	/**
+	 * @brief Sends a websocket message from a stream
+	 * @param source Ownership is transferred, the stream is deleted when sent or on failure
+	 * @param type
+	 * @retval bool true if the message was queued for sending
+	 * @note Content is read in blocks of WEBSOCKET_FRAGMENT_SIZE and sent as a fragmented message,
+	 * so files or templates of any size can be sent without buffering them in memory.
+	 */
+	bool send(IDataSourceStream* source, ws_frame_type_t type = WS_FRAME_TEXT);
+
 	/**
 	 * @brief Broadcasts a message to all active websocket connections
 	 * @param message
 	 * @param length
 	 * @param type
+	 * @note The frame is encoded once and shared by all server connections, bypassing any
+	 * send() override. Client connections are masked so each is encoded separately.
 	 */
 	static void broadcast(const char* message, size_t length, ws_frame_type_t type = WS_FRAME_TEXT);
 
@@ -260,6 +280,24 @@ public:
 		return state;
 	}
 
+	/** @brief Encode a frame header
+	 *  @param opcode Frame type, or 0 for a continuation frame
+	 *  @param payloadLength
+	 *  @param isFin true if this is the final frame of a message
+	 *  @param maskKey If not null, a random mask key is generated and returned here for masking the payload
+	 *  @param outData Must have space for WEBSOCKET_MAX_HEADER_SIZE bytes
+	 *  @retval size_t Size of header
+	 */
+	static size_t encodeHeader(uint8_t opcode, size_t payloadLength, bool isFin, uint8_t* maskKey, uint8_t* outData);
+
+	/** @brief Apply mask to a block of payload data
+	 *  @param data
+	 *  @param length
+	 *  @param maskKey The 4-byte key
+	 *  @param keyOffset Position in the key of the first byte, to resume part way through a payload
+	 */
+	static void maskPayload(uint8_t* data, size_t length, const uint8_t* maskKey, unsigned keyOffset = 0);
+
 protected:
 	// Static handlers for ws_parser
 	static int staticOnDataBegin(void* userData, ws_frame_type_t type);
@@ -287,8 +325,8 @@ protected:
 	 *  @param isFin true if this is the final frame
 	 *  @retval size_t Size of encoded frame
 	 */
-	size_t encodeFrame(ws_frame_type_t type, const char* inData, size_t inLength, char* outData, size_t outLength,
-					   bool useMask = true, bool isFin = true);
+	static size_t encodeFrame(ws_frame_type_t type, const char* inData, size_t inLength, char* outData,
+							  size_t outLength, bool useMask = true, bool isFin = true);
 
 protected:
 	WebsocketDelegate wsConnect = nullptr;
@@ -0,0 +1,120 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WebsocketFrameStream.cpp
+ *
+ ****/
+
+#include "WebsocketFrameStream.h"
+
+#define WEBSOCKET_OPCODE_CONTINUATION 0x00
+
+// Space reserved for the largest header, rounded up so payload is word-aligned for masking
+#define FRAME_PAYLOAD_OFFSET 16
+static_assert(FRAME_PAYLOAD_OFFSET >= WEBSOCKET_MAX_HEADER_SIZE, "Frame header space too small");
+
+static size_t getHeaderSize(size_t payloadLength, bool useMask)
+{
+	size_t size = 2;
+	if(payloadLength > 0xFFFF) {
+		size += 8;
+	} else if(payloadLength >= 126) {
+		size += 2;
+	}
+	return useMask ? size + 4 : size;
+}
+
+int WebsocketFrameStream::available()
+{
+	size_t count = frameEnd - framePos;
+	if(finalFrame || source == nullptr) {
+		return count;
+	}
+
+	int remaining = source->available();
+	if(remaining < 0) {
+		return -1;
+	}
+
+	// Known-length sources fill every fragment, ending with a partial (possibly empty) final frame
+	size_t fullFrames = remaining / WEBSOCKET_FRAGMENT_SIZE;
+	size_t lastLength = remaining % WEBSOCKET_FRAGMENT_SIZE;
+	count += fullFrames * (getHeaderSize(WEBSOCKET_FRAGMENT_SIZE, useMask) + WEBSOCKET_FRAGMENT_SIZE);
+	if(lastLength != 0 || fullFrames == 0) {
+		count += getHeaderSize(lastLength, useMask) + lastLength;
+	}
+	return count;
+}
+
+bool WebsocketFrameStream::fillFrame()
+{
+	if(source == nullptr) {
+		return false;
+	}
+
+	if(frame == nullptr) {
+		frame = new uint8_t[FRAME_PAYLOAD_OFFSET + WEBSOCKET_FRAGMENT_SIZE];
+		if(frame == nullptr) {
+			return false;
+		}
+	}
+
+	auto payload = frame + FRAME_PAYLOAD_OFFSET;
+	size_t length = 0;
+	while(length < WEBSOCKET_FRAGMENT_SIZE && !source->isFinished()) {
+		auto buf = reinterpret_cast<char*>(payload + length);
+		auto read = source->readMemoryBlock(buf, WEBSOCKET_FRAGMENT_SIZE - length);
+		if(read == 0) {
+			break;
+		}
+		source->seek(read);
+		length += read;
+	}
+
+	bool isFin = source->isFinished();
+	if(length == 0 && !isFin) {
+		// Source has no data yet
+		return false;
+	}
+
+	uint8_t header[WEBSOCKET_MAX_HEADER_SIZE];
+	uint8_t maskKey[4];
+	uint8_t opcode = started ? WEBSOCKET_OPCODE_CONTINUATION : type;
+	size_t headerLength = WebsocketConnection::encodeHeader(opcode, length, isFin, useMask ? maskKey : nullptr, header);
+	if(useMask) {
+		WebsocketConnection::maskPayload(payload, length, maskKey);
+	}
+
+	// Place header immediately before payload
+	framePos = FRAME_PAYLOAD_OFFSET - headerLength;
+	memcpy(frame + framePos, header, headerLength);
+	frameEnd = FRAME_PAYLOAD_OFFSET + length;
+	started = true;
+	finalFrame = isFin;
+
+	return true;
+}
+
+uint16_t WebsocketFrameStream::readMemoryBlock(char* data, int bufSize)
+{
+	if(framePos == frameEnd && (finalFrame || !fillFrame())) {
+		return 0;
+	}
+
+	int count = std::min(int(frameEnd - framePos), bufSize);
+	memcpy(data, frame + framePos, count);
+	return count;
+}
+
+bool WebsocketFrameStream::seek(int len)
+{
+	if(len < 0 || framePos + len > frameEnd) {
+		return false;
+	}
+
+	framePos += len;
+	return true;
+}
@@ -0,0 +1,79 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * WebsocketFrameStream.h
+ *
+ ****/
+
+#pragma once
+
+#include "WebsocketConnection.h"
+
+/** @addtogroup stream
+ *  @{
+ */
+
+/*
+ * WebsocketFrameStream
+ *
+ * Encodes content from a source stream as a fragmented websocket message. Up to WEBSOCKET_FRAGMENT_SIZE
+ * bytes are read into an internal buffer, then sent as a single frame; the first frame carries the message
+ * type and the remainder are continuation frames. The final frame is identified when the source reports
+ * it is finished, so streams of unknown length (e.g. templates) are supported.
+ */
+class WebsocketFrameStream : public IDataSourceStream
+{
+public:
+	/**
+	 * @param source Message content, deleted with this stream
+	 * @param type Frame type for the message
+	 * @param useMask MUST be true for client connections
+	 */
+	WebsocketFrameStream(IDataSourceStream* source, ws_frame_type_t type, bool useMask)
+		: source(source), type(type), useMask(useMask)
+	{
+	}
+
+	~WebsocketFrameStream()
+	{
+		delete[] frame;
+		delete source;
+	}
+
+	StreamType getStreamType() const override
+	{
+		return source ? source->getStreamType() : eSST_Invalid;
+	}
+
+	/**
+	 * @brief Encoded size of the remainder of the message, including frame headers
+	 * @retval int -1 if the source length is unknown
+	 */
+	int available() override;
+
+	uint16_t readMemoryBlock(char* data, int bufSize) override;
+
+	bool seek(int len) override;
+
+	bool isFinished() override
+	{
+		return finalFrame && framePos == frameEnd;
+	}
+
+private:
+	bool fillFrame();
+
+	IDataSourceStream* source;
+	uint8_t* frame = nullptr; ///< Header and payload of the current frame
+	size_t framePos = 0;
+	size_t frameEnd = 0;
+	ws_frame_type_t type;
+	bool useMask;
+	bool started = false;	///< First frame has been encoded
+	bool finalFrame = false; ///< Current frame completes the message
+};
+
+/** @} */
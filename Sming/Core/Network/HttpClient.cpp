@@ -19,30 +19,11 @@ bool HttpClient::send(HttpRequest* request)
 {
 	String cacheKey = getCacheKey(request->uri);
 
-	HttpClientConnection* connection = nullptr;
-
-	int i = httpConnectionPool.indexOf(cacheKey);
-	if(i >= 0) {
-		// Check existing connection
-		connection = httpConnectionPool.valueAt(i);
-		if(connection->getConnectionState() > eTCS_Connecting && !connection->isActive()) {
-			debug_d("Removing stale connection: State: %d, Active: %d", connection->getConnectionState(),
-					connection->isActive());
-			delete connection;
-			connection = nullptr;
-			httpConnectionPool.removeAt(i);
-		}
-	}
-
+	HttpClientConnection* connection = httpConnectionPool.getConnection(cacheKey);
 	if(connection == nullptr) {
-		debug_d("Creating new HttpClientConnection");
-		connection = new HttpClientConnection();
-		if(connection == nullptr) {
-			// Out of memory
-			delete request;
-			return false;
-		}
-		httpConnectionPool[cacheKey] = connection;
+		// Pool is full of busy connections, or out of memory
+		delete request;
+		return false;
 	}
 
 	return connection->send(request);
@@ -22,6 +22,7 @@
 #include "Http/HttpCommon.h"
 #include "Http/HttpRequest.h"
 #include "Http/HttpClientConnection.h"
+#include "Http/HttpConnectionPool.h"
 
 class HttpClient
 {
@@ -110,6 +111,14 @@ public:
 		httpConnectionPool.clear();
 	}
 
+	/**
+	 * @brief Get connection pool statistics, e.g. to check how often connections are re-used
+	 */
+	static const HttpConnectionPool::Stats& getPoolStats()
+	{
+		return httpConnectionPool.getStats();
+	}
+
 protected:
 	String getCacheKey(const Url& url)
 	{
@@ -117,7 +126,6 @@ protected:
 	}
 
 protected:
-	typedef ObjectMap<String, HttpClientConnection> HttpConnectionPool;
 	static HttpConnectionPool httpConnectionPool;
 };
 
@@ -23,9 +23,14 @@ void HttpServer::configure(const HttpServerSettings& settings)
 
 	if(settings.useDefaultBodyParsers) {
 		setBodyParser(ContentType::toString(MIME_FORM_URL_ENCODED), formUrlParser);
+		setBodyParser(ContentType::toString(MIME_FORM_MULTIPART), formMultipartParser);
 	}
 
 	setKeepAlive(settings.keepAliveSeconds);
+
+	if(settings.maxActiveConnections > 0 && !HttpServerConnection::reservePool(settings.maxActiveConnections)) {
+		debug_w("HttpServer: Unable to reserve %d pooled connections", settings.maxActiveConnections);
+	}
 #ifdef ENABLE_SSL
 	sslSessionCacheSize = settings.sslSessionCacheSize;
 #endif
@@ -26,13 +26,13 @@
 #include "Http/HttpBodyParser.h"
 
 typedef struct {
-	int maxActiveConnections = 10; ///< maximum number of concurrent requests..
+	int maxActiveConnections = 10; ///< maximum number of concurrent requests, also sets connection pool size
 	int keepAliveSeconds = 0;	  ///< default seconds to keep the connection alive before closing it
 	int minHeapSize = -1;		   ///< min heap size that is required to accept connection, -1 means use server default
 	bool useDefaultBodyParsers = 1; ///< if the default body parsers,  as form-url-encoded, should be used
 #ifdef ENABLE_SSL
 	int sslSessionCacheSize =
-		10; ///< number of SSL session ids to cache. Setting this to 0 will disable SSL session resumption.
+		SSL_SERVER_SESSION_CACHE_SIZE; ///< number of SSL session ids to cache, 0 disables SSL session resumption
 #endif
 } HttpServerSettings;
 
@@ -63,6 +63,9 @@ public:
 	 * 			There can be only one catch-all '*' body parser and that will be the last registered
 	 *
 	 * @param  parser
+	 *
+	 * @note Parsers return the number of bytes processed, see `HttpBodyParserDelegate`.
+	 * 		 Existing parsers returning `void` must be updated.
 	 */
 	void setBodyParser(const String& contentType, HttpBodyParserDelegate parser)
 	{
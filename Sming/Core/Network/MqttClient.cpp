@@ -347,7 +347,7 @@ void MqttClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 		uint8_t packet[packetLength];
 		mqtt_serialiser_write(&serialiser, outgoingMessage, packet, packetLength);
 
-		delete stream;
+		releaseStream(stream);
 		MemoryDataStream* headerStream = new MemoryDataStream();
 		headerStream->write(packet, packetLength);
 		if(outgoingMessage->common.type == MQTT_TYPE_PUBLISH && payloadStream) {
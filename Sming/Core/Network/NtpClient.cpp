@@ -17,9 +17,9 @@ NtpClient::NtpClient(const String& reqServer, unsigned reqIntervalSeconds, NtpTi
 	debug_d("NtpClient(\"%s\", %u)", reqServer.c_str(), reqIntervalSeconds);
 
 	// Setup timer, but don't start it
-	timer.setCallback(TimerDelegate(&NtpClient::requestTime, this));
+	timer.setCallback(TimerDelegate(&NtpClient::sendRequest, this));
 
-	this->server = reqServer;
+	addNtpServer(reqServer);
 	this->delegateCompleted = delegateFunction;
 	if(!delegateFunction) {
 		autoUpdateSystemClock = true;
@@ -32,10 +32,41 @@ NtpClient::NtpClient(const String& reqServer, unsigned reqIntervalSeconds, NtpTi
 	}
 }
 
+int64_t NtpClient::ntpToUnixUs(uint64_t timestamp)
+{
+	uint32_t ntpSeconds = timestamp >> 32;
+	int64_t seconds = ntpSeconds;
+	if(ntpSeconds < NTP_UNIX_EPOCH_OFFSET) {
+		seconds += 0x100000000LL;
+	}
+	seconds -= NTP_UNIX_EPOCH_OFFSET;
+	uint32_t microseconds = (((timestamp & 0xffffffffU) * 1000000ULL) + 0x80000000U) >> 32;
+	return (seconds * 1000000) + microseconds;
+}
+
+uint64_t NtpClient::unixUsToNtp(int64_t time)
+{
+	uint64_t seconds = uint64_t(time / 1000000) + NTP_UNIX_EPOCH_OFFSET;
+	uint64_t fraction = (uint64_t(time % 1000000) << 32) / 1000000;
+	return (seconds << 32) | fraction;
+}
+
 void NtpClient::requestTime()
 {
 	debug_d("NtpClient::requestTime()");
 
+	requestCount = 0;
+	sampleCount = 0;
+	sendRequest();
+}
+
+void NtpClient::sendRequest()
+{
+	if(requestCount >= NTP_SAMPLES_PER_UPDATE) {
+		completeUpdate();
+		return;
+	}
+
 	// Schedule a retry in anticipation of failure
 	startTimer(NTP_CONNECTION_TIMEOUT_MS);
 
@@ -44,6 +75,16 @@ void NtpClient::requestTime()
 		return;
 	}
 
+	if(servers.count() == 0) {
+		debug_e("NtpClient has no servers");
+		stopTimer();
+		return;
+	}
+
+	// A failed lookup counts as a request, so the retry moves on to the next server
+	server = servers[requestCount % servers.count()];
+	++requestCount;
+
 	ip_addr_t resolvedIp;
 	int result = dns_gethostbyname(server.c_str(), &resolvedIp,
 								   [](const char* name, LWIP_IP_ADDR_T* ip, void* arg) {
@@ -91,8 +132,15 @@ void NtpClient::internalRequestTime(IPAddress serverIp)
 	packet[0] = (NTP_VERSION << 3 | 0x03); // LI (0 = no warning), Protocol version (4), Client mode (3)
 	packet[1] = 0;						   // Stratum, or type of clock, unspecified.
 
-	// Start timer to retry if no response received
-	startTimer(NTP_RESPONSE_TIMEOUT_MS);
+	// Start timer to move on if no response received
+	startTimer(NTP_SAMPLE_TIMEOUT_MS);
+
+	// Server copies our transmit timestamp into the originate field of its reply, so we can match it up
+	requestTimeUs = SystemClock.nowUs(eTZ_UTC);
+	requestTimestamp = unixUsToNtp(requestTimeUs);
+	for(unsigned i = 0; i < 8; ++i) {
+		packet[40 + i] = requestTimestamp >> (56 - (i * 8));
+	}
 
 	// Send to server, serverAddress & port is set in connect
 	NtpClient::send(packet, NTP_PACKET_SIZE);
@@ -116,43 +164,144 @@ void NtpClient::setAutoQueryInterval(unsigned seconds)
 	}
 }
 
+static uint64_t readTimestamp(const uint8_t* data)
+{
+	uint64_t value = 0;
+	for(unsigned i = 0; i < 8; ++i) {
+		value = (value << 8) | data[i];
+	}
+	return value;
+}
+
 void NtpClient::onReceive(pbuf* buf, IPAddress remoteIP, uint16_t remotePort)
 {
-	debug_d("NtpClient::onReceive(%s:%u)", remoteIP.toString().c_str(), remotePort);
+	// Destination timestamp (T4)
+	int64_t receiveTimeUs = SystemClock.nowUs(eTZ_UTC);
 
-	stopTimer();
+	debug_d("NtpClient::onReceive(%s:%u)", remoteIP.toString().c_str(), remotePort);
 
 	// We do some basic check to see if it really is a ntp packet we receive.
 	// NTP version should be set to same as we used to send, NTP_VERSION
 	// NTP_VERSION 3 has time in same location so accept that too
 	// Mode should be set to NTP_MODE_SERVER
 
-	uint8_t versionMode = pbuf_get_at(buf, 0);
-	uint8_t ver = (versionMode & 0b00111000) >> 3;
-	uint8_t mode = (versionMode & 0x07);
+	uint8_t packet[NTP_PACKET_SIZE];
+	if(pbuf_copy_partial(buf, packet, NTP_PACKET_SIZE, 0) != NTP_PACKET_SIZE) {
+		debug_w("NTP packet too short");
+		return;
+	}
 
-	if(mode == NTP_MODE_SERVER && (ver == NTP_VERSION || ver == (NTP_VERSION - 1))) {
-		//Most likely a correct NTP packet received.
+	uint8_t leap = packet[0] >> 6;
+	uint8_t ver = (packet[0] & 0b00111000) >> 3;
+	uint8_t mode = (packet[0] & 0x07);
+	uint8_t stratum = packet[1];
 
-		uint32_t timestamp;
-		pbuf_copy_partial(buf, &timestamp, sizeof(timestamp), 40); // Copy only timestamp.
-		timestamp = ntohl(timestamp);
+	if(mode != NTP_MODE_SERVER || (ver != NTP_VERSION && ver != (NTP_VERSION - 1))) {
+		debug_w("Invalid NTP packet");
+		return;
+	}
 
-		// Unix time starts on Jan 1 1970, subtract 70 years:
-		uint32_t epoch = timestamp - 0x83AA7E80;
+	// Discard stale or unsolicited responses; timer continues to run for the outstanding request
+	if(requestTimestamp == 0 || readTimestamp(&packet[24]) != requestTimestamp) {
+		debug_w("NTP response doesn't match request");
+		return;
+	}
+	requestTimestamp = 0;
 
-		if(autoUpdateSystemClock) {
-			SystemClock.setTime(epoch, eTZ_UTC); // update systemclock utc value
+	// Stratum 0 is a 'kiss-of-death' (e.g. rate limit), leap indicator 3 means server isn't synchronised
+	uint64_t transmitTimestamp = readTimestamp(&packet[40]);
+	if(leap == 3 || stratum == 0 || stratum > 15 || transmitTimestamp == 0) {
+		debug_w("NTP server %s not usable (stratum %u, LI %u)", server.c_str(), stratum, leap);
+	} else {
+		int64_t t1 = requestTimeUs;
+		int64_t t2 = ntpToUnixUs(readTimestamp(&packet[32]));
+		int64_t t3 = ntpToUnixUs(transmitTimestamp);
+		int64_t t4 = receiveTimeUs;
+
+		int64_t offset = ((t2 - t1) + (t3 - t4)) / 2;
+		int64_t delay = (t4 - t1) - (t3 - t2);
+		if(delay < 0) {
+			// Clock resolution or server error
+			delay = 0;
 		}
 
-		if(delegateCompleted) {
-			delegateCompleted(*this, epoch);
+		debug_d("NTP %s: offset %d us, delay %d us", server.c_str(), int(offset), int(delay));
+
+		if(delay <= NTP_MAX_DELAY_US && sampleCount < NTP_SAMPLES_PER_UPDATE) {
+			auto& sample = samples[sampleCount++];
+			sample.offset = offset;
+			sample.delay = delay;
+			sample.serverIndex = (requestCount - 1) % servers.count();
 		}
+	}
 
-		// If auto query is enabled, schedule the next check
-		setAutoQuery(autoQueryEnabled);
+	if(requestCount < NTP_SAMPLES_PER_UPDATE) {
+		startTimer(NTP_SAMPLE_INTERVAL_MS);
 	} else {
-		// Got a dodgy packet so treat it as we would a response failure
+		completeUpdate();
+	}
+}
+
+void NtpClient::completeUpdate()
+{
+	requestCount = 0;
+	requestTimestamp = 0;
+
+	if(sampleCount == 0) {
+		// Treat as a response failure and try again later
+		debug_w("NtpClient: no valid responses");
 		startTimer(NTP_RESPONSE_TIMEOUT_MS);
+		return;
+	}
+
+	// Best (lowest delay) sample for each server, in order of offset
+	Sample best[NTP_SAMPLES_PER_UPDATE];
+	unsigned bestCount = 0;
+	for(unsigned i = 0; i < sampleCount; ++i) {
+		auto& sample = samples[i];
+		unsigned j = 0;
+		while(j < bestCount && best[j].serverIndex != sample.serverIndex) {
+			++j;
+		}
+		if(j == bestCount) {
+			++bestCount;
+		} else if(best[j].delay <= sample.delay) {
+			continue;
+		}
+		// Remove existing entry then insert keeping list sorted
+		for(; j + 1 < bestCount; ++j) {
+			best[j] = best[j + 1];
+		}
+		j = bestCount - 1;
+		while(j > 0 && best[j - 1].offset > sample.offset) {
+			best[j] = best[j - 1];
+			--j;
+		}
+		best[j] = sample;
+	}
+	sampleCount = 0;
+
+	// With three or more servers use the median, otherwise the sample with lowest delay
+	const Sample* chosen = &best[0];
+	if(bestCount >= 3) {
+		chosen = &best[bestCount / 2];
+	} else if(bestCount == 2 && best[1].delay < best[0].delay) {
+		chosen = &best[1];
 	}
+
+	lastOffset = chosen->offset;
+	lastDelay = chosen->delay;
+
+	time_t epoch = (SystemClock.nowUs(eTZ_UTC) + lastOffset) / 1000000;
+
+	if(autoUpdateSystemClock) {
+		SystemClock.adjustTime(lastOffset); // update systemclock utc value
+	}
+
+	if(delegateCompleted) {
+		delegateCompleted(*this, epoch);
+	}
+
+	// If auto query is enabled, schedule the next check
+	setAutoQuery(autoQueryEnabled);
 }
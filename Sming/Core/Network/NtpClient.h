@@ -21,6 +21,7 @@
 #include "Timer.h"
 #include "DateTime.h"
 #include "Delegate.h"
+#include "WVector.h"
 
 #define NTP_PORT 123
 #define NTP_PACKET_SIZE 48
@@ -33,13 +34,24 @@
 #define NTP_MIN_AUTOQUERY_SECONDS 10U	 ///< Minimum autoquery interval
 #define NTP_CONNECTION_TIMEOUT_MS 1666U   ///< Time to retry query when network connection unavailable
 #define NTP_RESPONSE_TIMEOUT_MS 20000U	///< Time to wait before retrying NTP query
+#define NTP_SAMPLES_PER_UPDATE 4U		  ///< Requests made for each update, rotating through the servers
+#define NTP_SAMPLE_INTERVAL_MS 2000U	  ///< Time between requests for an update
+#define NTP_SAMPLE_TIMEOUT_MS 2000U		  ///< Time to wait for each response
+#define NTP_MAX_DELAY_US 1000000U		  ///< Responses with a longer round-trip delay are discarded
+#define NTP_UNIX_EPOCH_OFFSET 0x83AA7E80U ///< Seconds from 1900 (NTP epoch) to 1970 (Unix epoch)
 
 class NtpClient;
 
 // Delegate constructor usage: (&YourClass::method, this)
 typedef Delegate<void(NtpClient& client, time_t ntpTime)> NtpTimeResultDelegate;
 
-/** @brief  NTP client class */
+/** @brief  NTP client class
+ *  @note   Each update sends NTP_SAMPLES_PER_UPDATE requests, spread across the configured servers.
+ *  Clock offset and round-trip delay are calculated from all four SNTPv4 timestamps to microsecond
+ *  resolution. The sample with the shortest delay from each server is the most accurate; if three or more
+ *  servers respond the median of these is used, so a single bad server can't pull the clock away.
+ *  The system clock is then slewed gradually by SystemClock.adjustTime() rather than stepped.
+ */
 class NtpClient : protected UdpConnection
 {
 public:
@@ -74,7 +86,18 @@ public:
      */
 	void setNtpServer(const String& server)
 	{
-		this->server = server;
+		servers.clear();
+		addNtpServer(server);
+	}
+
+	/** @brief  Add an NTP server to query
+     *  @param  server IP address or hostname of NTP server
+     */
+	void addNtpServer(const String& server)
+	{
+		if(server && !servers.contains(server)) {
+			servers.add(server);
+		}
 	}
 
 	/** @brief  Enable / disable periodic query
@@ -95,6 +118,35 @@ public:
 		autoUpdateSystemClock = autoUpdateClock;
 	}
 
+	/** @brief  Get clock offset determined by the last update
+     *  @retval int64_t Microseconds to add to local clock for correct time
+     */
+	int64_t getLastOffset() const
+	{
+		return lastOffset;
+	}
+
+	/** @brief  Get round-trip network delay of the sample used for the last update
+     *  @retval uint32_t Microseconds
+     */
+	uint32_t getLastDelay() const
+	{
+		return lastDelay;
+	}
+
+	/** @brief  Convert NTP 64-bit fixed-point timestamp to Unix time
+     *  @param  timestamp Seconds since 1900 in upper 32 bits, fraction in lower 32 bits
+     *  @retval int64_t Microseconds since 1970
+     *  @note   Times before 1970 are assumed to belong to the next NTP era, which starts in 2036
+     */
+	static int64_t ntpToUnixUs(uint64_t timestamp);
+
+	/** @brief  Convert Unix time to NTP 64-bit fixed-point timestamp
+     *  @param  time Microseconds since 1970
+     *  @retval uint64_t
+     */
+	static uint64_t unixUsToNtp(int64_t time);
+
 protected:
 	/** @brief  Handle UDP message reception
      *  @param  buf Pointer to data buffer containing UDP payload
@@ -108,6 +160,14 @@ protected:
      */
 	void internalRequestTime(IPAddress serverIp);
 
+	/** @brief  Send the next request for the current update, or complete it
+     */
+	void sendRequest();
+
+	/** @brief  Choose the best sample and update the clock
+     */
+	void completeUpdate();
+
 	/** @brief Start the timer running
 	 *  @param time to run in milliseconds
 	 */
@@ -125,7 +185,21 @@ protected:
 	}
 
 protected:
-	String server; ///< IP address or Hostname of NTP server
+	struct Sample {
+		int64_t offset; ///< Microseconds
+		uint32_t delay; ///< Microseconds
+		uint8_t serverIndex;
+	};
+
+	String server;			///< IP address or Hostname of NTP server currently being queried
+	Vector<String> servers; ///< All servers to query
+	Sample samples[NTP_SAMPLES_PER_UPDATE];
+	uint8_t sampleCount = 0;  ///< Valid responses received for this update
+	uint8_t requestCount = 0; ///< Requests made for this update
+	uint64_t requestTimestamp = 0; ///< NTP transmit timestamp of the outstanding request
+	int64_t requestTimeUs = 0;	 ///< UTC time of the outstanding request according to the system clock
+	int64_t lastOffset = 0;
+	uint32_t lastDelay = 0;
 
 	NtpTimeResultDelegate delegateCompleted = nullptr; ///< NTP result handler delegate
 	bool autoUpdateSystemClock = false;				   ///< True to update system clock with NTP time
@@ -254,8 +254,10 @@ void SmtpClient::onReadyToSendData(TcpConnectionEvent sourceEvent)
 
 		// send the final dot
 		state = eSMTP_Sent;
-		delete stream;
-		stream = nullptr;
+		if(buffer == stream) {
+			buffer = nullptr;
+		}
+		releaseStream(stream);
 
 		sendString(F("\r\n.\r\n"));
 		break;
@@ -325,7 +327,10 @@ bool SmtpClient::sendMailBody(MailMessage* mail)
 		return true;
 	}
 
-	delete stream;
+	if(buffer == stream) {
+		buffer = nullptr;
+	}
+	releaseStream(stream);
 	stream = mail->stream; // avoid intermediate buffers
 	mail->stream = nullptr;
 
@@ -0,0 +1,104 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SslContextCache.cpp
+ *
+ ****/
+
+#ifdef ENABLE_SSL
+
+#include "SslContextCache.h"
+
+SslContextCache SslContexts;
+
+void SslContextCache::getKeyCertHash(SslKeyCertPair& keyCert, uint8_t hash[SHA1_SIZE])
+{
+	if(!keyCert.isValid()) {
+		memset(hash, 0, SHA1_SIZE);
+		return;
+	}
+
+	uint8_t parts[3][SHA1_SIZE];
+	sha1(parts[0], keyCert.getKey(), keyCert.getKeyLength());
+	sha1(parts[1], keyCert.getCertificate(), keyCert.getCertificateLength());
+	auto password = keyCert.getKeyPassword();
+	sha1(parts[2], password, (password == nullptr) ? 0 : strlen(password));
+	sha1(hash, parts, sizeof(parts));
+}
+
+SSLCTX* SslContextCache::createContext(uint32_t options, SslKeyCertPair& keyCert)
+{
+	auto context = ssl_ctx_new(options, 1);
+	if(context == nullptr || !keyCert.isValid()) {
+		return context;
+	}
+
+	// if we have client certificate -> try to use it.
+	if(ssl_obj_memory_load(context, SSL_OBJ_RSA_KEY, keyCert.getKey(), keyCert.getKeyLength(),
+						   keyCert.getKeyPassword()) != SSL_OK) {
+		debug_d("SSL: Unable to load client private key");
+	} else if(ssl_obj_memory_load(context, SSL_OBJ_X509_CERT, keyCert.getCertificate(),
+								  keyCert.getCertificateLength(), nullptr) != SSL_OK) {
+		debug_d("SSL: Unable to load client certificate");
+	}
+
+	return context;
+}
+
+SSLCTX* SslContextCache::acquire(uint32_t options, SslKeyCertPair& keyCert)
+{
+	uint8_t hash[SHA1_SIZE];
+	getKeyCertHash(keyCert, hash);
+
+	Entry* freeEntry = nullptr;
+	for(auto& entry : entries) {
+		if(entry.context == nullptr) {
+			if(freeEntry == nullptr) {
+				freeEntry = &entry;
+			}
+			continue;
+		}
+		if(entry.options == options && memcmp(entry.keyCertHash, hash, SHA1_SIZE) == 0) {
+			++entry.refCount;
+			debug_d("SSL: Sharing context, %u connections", entry.refCount);
+			return entry.context;
+		}
+	}
+
+	auto context = createContext(options, keyCert);
+	if(context == nullptr || freeEntry == nullptr) {
+		// Cache is full, so the context is used only by this connection
+		return context;
+	}
+
+	freeEntry->context = context;
+	freeEntry->refCount = 1;
+	freeEntry->options = options;
+	memcpy(freeEntry->keyCertHash, hash, SHA1_SIZE);
+	return context;
+}
+
+void SslContextCache::release(SSLCTX* context)
+{
+	if(context == nullptr) {
+		return;
+	}
+
+	for(auto& entry : entries) {
+		if(entry.context != context) {
+			continue;
+		}
+		if(--entry.refCount != 0) {
+			return;
+		}
+		entry.context = nullptr;
+		break;
+	}
+
+	ssl_ctx_free(context);
+}
+
+#endif // ENABLE_SSL
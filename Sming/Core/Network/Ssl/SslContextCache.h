@@ -0,0 +1,58 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SslContextCache.h
+ *
+ ****/
+
+#pragma once
+
+#include "SslKeyCertPair.h"
+#include "Network/WebHelpers/aw-sha1.h"
+
+/// Maximum number of distinct client contexts which may be shared
+#ifndef SSL_CONTEXT_CACHE_SIZE
+#define SSL_CONTEXT_CACHE_SIZE 2
+#endif
+
+/** @brief Reference-counted client SSL contexts
+ *
+ *  Connections using the same options and client key/certificate share a single context, so the
+ *  key and certificate are parsed once rather than for every connection. Contexts are freed
+ *  when the last connection using them is closed.
+ */
+class SslContextCache
+{
+public:
+	/** @brief Obtain a context, creating it if necessary
+	 *  @param options SSL options for the context
+	 *  @param keyCert Optional client key and certificate
+	 *  @retval SSLCTX* Must be returned by calling `release()`
+	 */
+	SSLCTX* acquire(uint32_t options, SslKeyCertPair& keyCert);
+
+	/** @brief Release a context obtained via `acquire()`
+	 *  @param context
+	 *  @note Individual SSL connections must be freed before calling this
+	 */
+	void release(SSLCTX* context);
+
+private:
+	struct Entry {
+		SSLCTX* context;
+		unsigned refCount;
+		uint32_t options;
+		uint8_t keyCertHash[SHA1_SIZE]; ///< Identifies key/certificate without keeping a copy
+	};
+
+	static void getKeyCertHash(SslKeyCertPair& keyCert, uint8_t hash[SHA1_SIZE]);
+	static SSLCTX* createContext(uint32_t options, SslKeyCertPair& keyCert);
+
+	Entry entries[SSL_CONTEXT_CACHE_SIZE] = {};
+};
+
+/** @brief Global context cache used by client connections */
+extern SslContextCache SslContexts;
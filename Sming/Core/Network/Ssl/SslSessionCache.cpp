@@ -0,0 +1,96 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SslSessionCache.cpp
+ *
+ ****/
+
+#include "SslSessionCache.h"
+
+#ifdef ENABLE_SSL
+SslSessionCache SslSessions;
+#endif
+
+int SslSessionCache::find(const String& key) const
+{
+	for(unsigned i = 0; i < used; ++i) {
+		if(entries[i].key == key) {
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void SslSessionCache::moveToFront(unsigned index)
+{
+	if(index == 0) {
+		return;
+	}
+
+	Entry entry = std::move(entries[index]);
+	for(unsigned i = index; i > 0; --i) {
+		entries[i] = std::move(entries[i - 1]);
+	}
+	entries[0] = std::move(entry);
+}
+
+bool SslSessionCache::load(const String& key, SslSessionId& session)
+{
+	int i = find(key);
+	if(i < 0) {
+		return false;
+	}
+
+	moveToFront(i);
+	session = entries[0].session;
+	return session.isValid();
+}
+
+void SslSessionCache::store(const String& key, const uint8_t* sessionId, unsigned length)
+{
+	if(length == 0) {
+		remove(key);
+		return;
+	}
+
+	int i = find(key);
+	if(i < 0) {
+		// Re-use the last entry, evicting it if the cache is full
+		if(used < SSL_SESSION_CACHE_SIZE) {
+			++used;
+		}
+		i = used - 1;
+		entries[i].key = key;
+	}
+
+	moveToFront(i);
+	if(!entries[0].session.assign(sessionId, length)) {
+		remove(key);
+	}
+}
+
+void SslSessionCache::remove(const String& key)
+{
+	int i = find(key);
+	if(i < 0) {
+		return;
+	}
+
+	--used;
+	for(unsigned j = i; j < used; ++j) {
+		entries[j] = std::move(entries[j + 1]);
+	}
+	entries[used] = Entry();
+}
+
+void SslSessionCache::clear()
+{
+	for(unsigned i = 0; i < used; ++i) {
+		entries[i] = Entry();
+	}
+	used = 0;
+}
@@ -0,0 +1,76 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * SslSessionCache.h
+ *
+ ****/
+
+#pragma once
+
+#include "SslSessionId.h"
+
+/// Number of client sessions to retain for resumption
+#ifndef SSL_SESSION_CACHE_SIZE
+#define SSL_SESSION_CACHE_SIZE 4
+#endif
+
+/** @brief Least-recently-used cache of client session IDs, keyed by "host:port"
+ *
+ *  Client connections look up a session here before starting the handshake, and store the result
+ *  when it completes. A resumed session skips the key exchange, which takes seconds on an ESP8266,
+ *  so repeated connections to the same server (e.g. HttpClient, MqttClient, WebsocketClient)
+ *  become much faster without the application having to keep track of session IDs.
+ *
+ *  The cache doesn't depend on the SSL library, so it can be built and tested without ENABLE_SSL.
+ */
+class SslSessionCache
+{
+public:
+	/** @brief Fetch a cached session
+	 *  @param key
+	 *  @param session On success, receives a copy of the session ID
+	 *  @retval bool true if session was found
+	 */
+	bool load(const String& key, SslSessionId& session);
+
+	/** @brief Add or update a session, discarding the least recently used if the cache is full
+	 *  @param key
+	 *  @param sessionId
+	 *  @param length
+	 */
+	void store(const String& key, const uint8_t* sessionId, unsigned length);
+
+	/** @brief Remove a session, e.g. if resumption failed
+	 *  @param key
+	 */
+	void remove(const String& key);
+
+	/** @brief Remove all sessions
+	 */
+	void clear();
+
+	unsigned count() const
+	{
+		return used;
+	}
+
+private:
+	int find(const String& key) const;
+	void moveToFront(unsigned index);
+
+	struct Entry {
+		String key;
+		SslSessionId session;
+	};
+
+	Entry entries[SSL_SESSION_CACHE_SIZE]; ///< Most recently used first
+	unsigned used = 0;
+};
+
+#ifdef ENABLE_SSL
+/** @brief Global session cache used by client connections */
+extern SslSessionCache SslSessions;
+#endif
@@ -10,7 +10,6 @@
 
 #pragma once
 
-#include "ssl/ssl.h"
 #include "WString.h"
 
 /** @brief Manages buffer to store SSL Session ID
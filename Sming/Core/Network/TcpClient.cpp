@@ -13,6 +13,15 @@
 
 void TcpClient::freeStreams()
 {
+	// Queued streams haven't been written yet so can be deleted directly
+	IDataSourceStream* queued;
+	while((queued = streamQueue.dequeue()) != nullptr) {
+		if(queued == buffer) {
+			buffer = nullptr;
+		}
+		delete queued;
+	}
+
 	if(buffer != nullptr) {
 		if(buffer != stream) {
 			debug_e("TcpClient: buffer doesn't match stream");
@@ -21,8 +30,7 @@ void TcpClient::freeStreams()
 		buffer = nullptr;
 	}
 
-	delete stream;
-	stream = nullptr;
+	releaseStream(stream);
 }
 
 void TcpClient::setBuffer(ReadWriteStream* stream)
@@ -59,15 +67,29 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 	}
 
 	if(buffer == nullptr) {
-		setBuffer(new MemoryDataStream());
+		if(stream == nullptr) {
+			setBuffer(new MemoryDataStream());
+		} else {
+			// Data must follow the active stream
+			auto newBuffer = new MemoryDataStream();
+			if(newBuffer != nullptr && !streamQueue.enqueue(newBuffer)) {
+				debug_e("TcpClient::send ERROR: Stream queue full");
+				delete newBuffer;
+				return false;
+			}
+			buffer = newBuffer;
+		}
 		if(buffer == nullptr) {
 			return false;
 		}
 	}
 
 	if(buffer->write((const uint8_t*)data, len) != len) {
-		debug_e("TcpClient::send ERROR: Unable to store %d bytes in buffer", len);
-		return false;
+		// Buffer cannot grow whilst the TCP stack is referencing it
+		if(!replaceBuffer() || buffer->write((const uint8_t*)data, len) != len) {
+			debug_e("TcpClient::send ERROR: Unable to store %d bytes in buffer", len);
+			return false;
+		}
 	}
 
 	debug_d("Storing %d bytes in stream", len);
@@ -78,6 +100,64 @@ bool TcpClient::send(const char* data, uint16_t len, bool forceCloseAfterSent)
 	return true;
 }
 
+bool TcpClient::send(IDataSourceStream* source, bool forceCloseAfterSent)
+{
+	if(source == nullptr) {
+		return false;
+	}
+
+	if(state != eTCS_Connecting && state != eTCS_Connected) {
+		delete source;
+		return false;
+	}
+
+	if(stream == nullptr) {
+		stream = source;
+	} else if(!streamQueue.enqueue(source)) {
+		debug_e("TcpClient::send ERROR: Stream queue full");
+		delete source;
+		return false;
+	}
+
+	// Any further data from send() must go after this stream
+	buffer = nullptr;
+
+	int len = source->available();
+	if(len > 0) {
+		asyncTotalLen += len;
+	}
+	asyncCloseAfterSent = forceCloseAfterSent;
+
+	return true;
+}
+
+bool TcpClient::replaceBuffer()
+{
+	/*
+	 * The TCP stack may still be referencing memory in the current buffer, which therefore cannot be resized.
+	 * Move unsent data into a new buffer and release the old one when it's no longer required.
+	 */
+	if(buffer == nullptr || buffer != stream) {
+		return false;
+	}
+
+	auto newBuffer = new MemoryDataStream();
+	if(newBuffer == nullptr) {
+		return false;
+	}
+
+	int available = buffer->available();
+	if(available > 0 && newBuffer->copyFrom(buffer, available) != size_t(available)) {
+		delete newBuffer;
+		return false;
+	}
+
+	releaseStream(stream);
+	buffer = newBuffer;
+	stream = newBuffer;
+	return true;
+}
+
 err_t TcpClient::onConnected(err_t err)
 {
 	if(err == ERR_OK) {
@@ -150,16 +230,25 @@ void TcpClient::close()
 
 void TcpClient::pushAsyncPart()
 {
-	if(stream == nullptr) {
-		return;
-	}
+	while(stream != nullptr) {
+		// Streams of unknown length weren't counted by send(), so count their data as it's written
+		bool countWritten = (stream->available() < 0);
+		int written = write(stream);
+		if(countWritten && written > 0) {
+			asyncTotalLen += written;
+		}
 
-	write(stream);
+		if(!stream->isFinished()) {
+			break;
+		}
 
-	if(stream->isFinished()) {
 		flush();
 		debug_d("TcpClient stream finished");
-		freeStreams();
+		if(buffer == stream) {
+			buffer = nullptr;
+		}
+		releaseStream(stream);
+		stream = streamQueue.dequeue();
 	}
 }
 
@@ -18,6 +18,7 @@
 
 #include "TcpConnection.h"
 #include "Delegate.h"
+#include "Data/ObjectQueue.h"
 
 #ifdef ENABLE_SSL
 #include "Ssl/SslValidator.h"
@@ -36,6 +37,11 @@ enum TcpClientState { eTCS_Ready, eTCS_Connecting, eTCS_Connected, eTCS_Successf
 // By default a TCP client connection has 70 seconds timeout
 #define TCP_CLIENT_TIMEOUT 70
 
+// Maximum number of streams which may be queued behind the active one
+#ifndef TCP_CLIENT_STREAM_QUEUE_SIZE
+#define TCP_CLIENT_STREAM_QUEUE_SIZE 8
+#endif
+
 class TcpClient : public TcpConnection
 {
 public:
@@ -101,6 +107,15 @@ public:
 		return send(data.c_str(), data.length(), forceCloseAfterSent);
 	}
 
+	/**	@brief	Queue a stream to be sent after any data already pending
+	 *	@param	source Ownership is transferred to the connection, it is deleted on failure
+	 *	@param	forceCloseAfterSent
+	 *	@retval bool true if stream was queued
+	 *	@note Use with a SharedMemoryStream to send the same content to several connections
+	 *	without copying it.
+	 */
+	bool send(IDataSourceStream* source, bool forceCloseAfterSent = false);
+
 	bool isProcessing()
 	{
 		return state == eTCS_Connected || state == eTCS_Connecting;
@@ -176,9 +191,11 @@ protected:
 
 protected:
 	void setBuffer(ReadWriteStream* stream);
+	bool replaceBuffer();
 
 	ReadWriteStream* buffer = nullptr;   ///< Used internally to buffer arbitrary data via send() methods
 	IDataSourceStream* stream = nullptr; ///< The currently active stream being sent
+	ObjectQueue<IDataSourceStream, TCP_CLIENT_STREAM_QUEUE_SIZE> streamQueue; ///< Streams waiting to be sent
 
 private:
 	TcpClientState state = eTCS_Ready;
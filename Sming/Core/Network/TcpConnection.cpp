@@ -9,12 +9,14 @@
  ****/
 
 #include "TcpConnection.h"
+#include "TcpZeroCopy.h"
 
 #include "Data/Stream/DataSourceStream.h"
 #include "Platform/WDT.h"
 #include "NetUtils.h"
 #include "WString.h"
 #include "IPAddress.h"
+#include "Services/Profiling/EventProfiler.h"
 
 #ifdef DEBUG_TCP_EXTENDED
 #define debug_tcp(fmt, ...) debug_d(fmt, ##__VA_ARGS__)
@@ -22,6 +24,14 @@
 #define debug_tcp(fmt, ...) debug_none(fmt, ##__VA_ARGS__)
 #endif
 
+void TcpConnection::releaseStream(IDataSourceStream*& stream)
+{
+	if(!TcpZeroCopy::release(stream)) {
+		delete stream;
+	}
+	stream = nullptr;
+}
+
 TcpConnection::~TcpConnection()
 {
 	autoSelfDestruct = false;
@@ -51,6 +61,7 @@ bool TcpConnection::connect(const String& server, int port, bool useSsl, uint32_
 		sslExtension = ssl_ext_new();
 		ssl_ext_set_host_name(sslExtension, server.c_str());
 		ssl_ext_set_max_fragment_size(sslExtension, 4); // 4K max size
+		sslSessionCacheKey = server + ':' + port;
 	}
 #endif
 
@@ -89,6 +100,9 @@ bool TcpConnection::connect(IPAddress addr, uint16_t port, bool useSsl, uint32_t
 	this->useSsl = useSsl;
 #ifdef ENABLE_SSL
 	this->sslOptions |= sslOptions;
+	if(useSsl) {
+		sslSessionCacheKey = addr.toString() + ':' + port;
+	}
 #endif
 
 	return internalConnect(addr, port);
@@ -246,6 +260,11 @@ int TcpConnection::write(IDataSourceStream* stream)
 	int available;
 	int total = 0;
 	char buffer[NETWORK_SEND_BUFFER_SIZE];
+	bool zeroCopy = true;
+#ifdef ENABLE_SSL
+	// Data is encrypted into a new buffer anyway
+	zeroCopy = (ssl == nullptr);
+#endif
 
 	do {
 		space = (tcp_sndqueuelen(tcp) < TCP_SND_QUEUELEN);
@@ -259,15 +278,28 @@ int TcpConnection::write(IDataSourceStream* stream)
 		int pushCount = 0;
 		do {
 			pushCount++;
-			int read = std::min((uint16_t)NETWORK_SEND_BUFFER_SIZE, getAvailableWriteSize());
-			if(read > 0) {
-				available = stream->readMemoryBlock(buffer, read);
+			const char* data = nullptr;
+			size_t blockSize = zeroCopy ? stream->getMemoryBlock(data) : 0;
+			uint8_t apiflags = TCP_WRITE_FLAG_MORE;
+			if(blockSize > 0) {
+				// Stream memory is stable so pass it directly to lwIP
+				available = std::min(blockSize, size_t(getAvailableWriteSize()));
 			} else {
-				available = 0;
+				int read = std::min((uint16_t)NETWORK_SEND_BUFFER_SIZE, getAvailableWriteSize());
+				if(read > 0) {
+					available = stream->readMemoryBlock(buffer, read);
+				} else {
+					available = 0;
+				}
+				data = buffer;
+				apiflags |= TCP_WRITE_FLAG_COPY;
 			}
 
 			if(available > 0) {
-				int written = write(buffer, available, TCP_WRITE_FLAG_COPY | TCP_WRITE_FLAG_MORE);
+				int written = write(data, available, apiflags);
+				if(written > 0 && data != buffer) {
+					TcpZeroCopy::add(tcp, stream);
+				}
 				total += written;
 				stream->seek(std::max(written, 0));
 				debug_d("TCP Written: %d, Available: %d, isFinished: %d, PushCount: %d [TcpBuf: %d]", written,
@@ -300,8 +332,13 @@ void TcpConnection::close()
 	axl_free(tcp);
 #endif
 
-	tcp_poll(tcp, staticOnPoll, 1);
-	tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
+	if(TcpZeroCopy::pending(tcp)) {
+		// Closed when lwIP has finished with stream memory
+		detachZeroCopy(tcp);
+	} else {
+		tcp_poll(tcp, staticOnPoll, 1);
+		tcp_arg(tcp, nullptr); // reset pointer to close connection on next callback
+	}
 	tcp = nullptr;
 
 	checkSelfFree();
@@ -361,6 +398,11 @@ void TcpConnection::closeTcpConnection(tcp_pcb* tpcb)
 		return;
 	}
 
+	if(TcpZeroCopy::pending(tpcb)) {
+		detachZeroCopy(tpcb);
+		return;
+	}
+
 	debug_d("-TCP connection");
 
 	tcp_arg(tpcb, nullptr);
@@ -378,6 +420,45 @@ void TcpConnection::closeTcpConnection(tcp_pcb* tpcb)
 	}
 }
 
+/*
+ * The application has finished with this connection but lwIP still references stream memory.
+ * Keep the connection open until all that data has been acknowledged, discarding anything received.
+ * Closing it now would risk the final acknowledgement being processed without a sent callback.
+ */
+void TcpConnection::detachZeroCopy(tcp_pcb* tpcb)
+{
+	debug_d("TCP connection detached, waiting for zero-copy data to be acknowledged");
+
+	tcp_arg(tpcb, tpcb);
+	tcp_recv(tpcb, [](void* arg, tcp_pcb* tcp, pbuf* p, err_t err) -> err_t {
+		if(p != nullptr) {
+			tcp_recved(tcp, p->tot_len);
+			pbuf_free(p);
+		}
+		return ERR_OK;
+	});
+	tcp_sent(tpcb, detachedOnSent);
+	tcp_err(tpcb, [](void* arg, err_t err) { TcpZeroCopy::remove(static_cast<tcp_pcb*>(arg), true); });
+	tcp_poll(tpcb, detachedOnPoll, 4);
+}
+
+err_t TcpConnection::detachedOnSent(void* arg, tcp_pcb* tcp, uint16_t len)
+{
+	TcpZeroCopy::remove(tcp, false);
+	if(!TcpZeroCopy::pending(tcp)) {
+		closeTcpConnection(tcp);
+	}
+	return ERR_OK;
+}
+
+err_t TcpConnection::detachedOnPoll(void* arg, tcp_pcb* tcp)
+{
+	if(!TcpZeroCopy::pending(tcp)) {
+		closeTcpConnection(tcp);
+	}
+	return ERR_OK;
+}
+
 void TcpConnection::flush()
 {
 	if(tcp && tcp->state == ESTABLISHED) {
@@ -433,33 +514,33 @@ err_t TcpConnection::internalOnConnected(err_t err)
 #endif
 			debug_d("SSL: handshake start (%d ms)", millis());
 
-			ssl_ctx_free(sslContext);
-			sslContext = ssl_ctx_new(SSL_CONNECT_IN_PARTS | localSslOptions, 1);
-
-			if(sslKeyCert.isValid()) {
-				// if we have client certificate -> try to use it.
-				if(ssl_obj_memory_load(sslContext, SSL_OBJ_RSA_KEY, sslKeyCert.getKey(), sslKeyCert.getKeyLength(),
-									   sslKeyCert.getKeyPassword()) != SSL_OK) {
-					debug_d("SSL: Unable to load client private key");
-				} else if(ssl_obj_memory_load(sslContext, SSL_OBJ_X509_CERT, sslKeyCert.getCertificate(),
-											  sslKeyCert.getCertificateLength(), nullptr) != SSL_OK) {
-					debug_d("SSL: Unable to load client certificate");
-				}
+			SslContexts.release(sslContext);
+			sslContext = SslContexts.acquire(SSL_CONNECT_IN_PARTS | localSslOptions, sslKeyCert);
+			if(freeKeyCertAfterHandshake) {
+				sslKeyCert.free();
+			}
 
-				if(freeKeyCertAfterHandshake) {
-					sslKeyCert.free();
-				}
+			// Use an explicitly provided session, otherwise try the cache
+			SslSessionId cachedSession;
+			SslSessionId* session = sslSessionId;
+			if(session == nullptr && SslSessions.load(sslSessionCacheKey, cachedSession)) {
+				session = &cachedSession;
 			}
 
-			debug_d("SSL: Session Id Length: %u", sslSessionId->getLength());
-			if(sslSessionId->isValid()) {
+			debug_d("SSL: Session Id Length: %u", session->getLength());
+			if(session->isValid()) {
 				debug_d("-----BEGIN SSL SESSION PARAMETERS-----");
-				debug_hex(DBG, "Session", sslSessionId->getValue(), sslSessionId->getLength());
+				debug_hex(DBG, "Session", session->getValue(), session->getLength());
 				debug_d("\n-----END SSL SESSION PARAMETERS-----");
 			}
 
-			ssl =
-				ssl_client_new(sslContext, clientfd, sslSessionId->getValue(), sslSessionId->getLength(), sslExtension);
+			ssl = ssl_client_new(sslContext, clientfd, session->getValue(), session->getLength(), sslExtension);
+			if(ssl == nullptr) {
+				debug_d("SSL: Unable to create connection");
+				SslContexts.release(sslContext);
+				sslContext = nullptr;
+				return ERR_OK;
+			}
 			if(ssl_handshake_status(ssl) != SSL_OK) {
 				debug_d("SSL: handshake is in progress...");
 				return SSL_OK;
@@ -469,9 +550,7 @@ err_t TcpConnection::internalOnConnected(err_t err)
 			debug_d("SSL: Switching back 80 MHz");
 			System.setCpuFrequency(eCF_80MHz);
 #endif
-			if(sslSessionId != nullptr) {
-				sslSessionId->assign(ssl->session_id, ssl->sess_id_size);
-			}
+			storeSslSession();
 		}
 	}
 #endif
@@ -527,6 +606,11 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 				return ERR_OK;
 			}
 
+			if(!sslConnected) {
+				// Don't attempt to resume a session which may have caused this
+				SslSessions.remove(sslSessionCacheKey);
+			}
+
 			close();
 			closeTcpConnection(tcp);
 			return read_bytes;
@@ -535,7 +619,8 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 		if(read_bytes == 0) {
 			if(!sslConnected && ssl_handshake_status(ssl) == SSL_OK) {
 				sslConnected = true;
-				debug_d("SSL: Handshake done (%d ms).", millis());
+				debug_d("SSL: Handshake done (%d ms), session %s.", millis(),
+						(ssl->flag & SSL_SESSION_RESUME) ? "resumed" : "new");
 #ifndef SSL_SLOW_CONNECT
 				debug_d("SSL: Switching back to 80 MHz");
 				System.setCpuFrequency(eCF_80MHz); // Preserve some CPU cycles
@@ -547,9 +632,7 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 					return ERR_ABRT;
 				}
 
-				if(sslSessionId != nullptr) {
-					sslSessionId->assign(ssl->session_id, ssl->sess_id_size);
-				}
+				storeSslSession();
 
 				err_t res = onConnected(err);
 				checkSelfFree();
@@ -569,7 +652,11 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 	}
 #endif
 
-	err_t res = onReceive(p);
+	err_t res;
+	{
+		PROFILE_EVENT(TCP_RECEIVE, this);
+		res = onReceive(p);
+	}
 
 	if(p != nullptr) {
 		pbuf_free(p);
@@ -586,7 +673,12 @@ err_t TcpConnection::internalOnReceive(pbuf* p, err_t err)
 err_t TcpConnection::internalOnSent(uint16_t len)
 {
 	sleep = 0;
-	err_t res = onSent(len);
+	TcpZeroCopy::remove(tcp, false);
+	err_t res;
+	{
+		PROFILE_EVENT(TCP_SENT, this);
+		res = onSent(len);
+	}
 	checkSelfFree();
 	debug_tcp("<TCP sent");
 	return res;
@@ -610,7 +702,11 @@ err_t TcpConnection::internalOnPoll()
 	//	return ERR_OK;
 
 	sleep++;
-	err_t res = onPoll();
+	err_t res;
+	{
+		PROFILE_EVENT(TCP_POLL, this);
+		res = onPoll();
+	}
 	checkSelfFree();
 	debug_tcp("<TCP poll");
 	return res;
@@ -618,6 +714,7 @@ err_t TcpConnection::internalOnPoll()
 
 void TcpConnection::internalOnError(err_t err)
 {
+	TcpZeroCopy::remove(tcp, true);
 	tcp = nullptr; // IMPORTANT. No available connection after error!
 	onError(err);
 	checkSelfFree();
@@ -651,10 +748,23 @@ void TcpConnection::closeSsl()
 	}
 
 	debug_d("SSL: closing ...");
-	ssl_ctx_free(sslContext);
-	sslContext = nullptr;
+	// Contexts are shared (by a server, or client connections) so free just this connection
+	ssl_free(ssl);
+	if(sslContext != nullptr) {
+		SslContexts.release(sslContext);
+		sslContext = nullptr;
+	}
 	sslExtension = nullptr;
 	ssl = nullptr;
 	sslConnected = false;
 }
+
+void TcpConnection::storeSslSession()
+{
+	if(sslSessionId != nullptr) {
+		sslSessionId->assign(ssl->session_id, ssl->sess_id_size);
+	} else if(sslSessionCacheKey) {
+		SslSessions.store(sslSessionCacheKey, ssl->session_id, ssl->sess_id_size);
+	}
+}
 #endif
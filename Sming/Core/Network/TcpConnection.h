@@ -19,6 +19,8 @@
 #include "axtls-8266/compat/lwipr_compat.h"
 #include "Clock.h"
 #include "Ssl/SslStructs.h"
+#include "Ssl/SslContextCache.h"
+#include "Ssl/SslSessionCache.h"
 #endif
 
 #include "WiringFrameworkDependencies.h"
@@ -87,8 +89,22 @@ public:
 	 */
 	virtual int write(const char* data, int len, uint8_t apiflags = TCP_WRITE_FLAG_COPY);
 
+	/** @brief Write as much stream data as the connection will accept
+	 *  @param stream
+	 *  @retval int Number of bytes written
+	 *  @note If the stream provides direct access to its memory (see `IDataSourceStream::getMemoryBlock()`)
+	 *  then the data is passed to the TCP stack without copying. The stream must therefore be disposed of
+	 *  using `releaseStream()`, which defers deletion until the data has been acknowledged.
+	 */
 	int write(IDataSourceStream* stream);
 
+	/** @brief Delete a stream which has been passed to `write(IDataSourceStream*)`
+	 *  @param stream Set to nullptr on return
+	 *  @note If the TCP stack still references memory owned by the stream then it is deleted
+	 *  later, once all the data has been acknowledged or the connection is aborted.
+	 */
+	static void releaseStream(IDataSourceStream*& stream);
+
 	uint16_t getAvailableWriteSize()
 	{
 		return (canSend && tcp) ? tcp_sndbuf(tcp) : 0;
@@ -263,6 +279,9 @@ protected:
 private:
 	static err_t staticOnPoll(void* arg, tcp_pcb* tcp);
 	static void closeTcpConnection(tcp_pcb* tpcb);
+	static void detachZeroCopy(tcp_pcb* tpcb);
+	static err_t detachedOnSent(void* arg, tcp_pcb* tcp, uint16_t len);
+	static err_t detachedOnPoll(void* arg, tcp_pcb* tcp);
 
 	inline void checkSelfFree()
 	{
@@ -285,7 +304,8 @@ protected:
 	uint32_t sslOptions = 0;
 	SslKeyCertPair sslKeyCert;
 	bool freeKeyCertAfterHandshake = false;
-	SslSessionId* sslSessionId = nullptr;
+	SslSessionId* sslSessionId = nullptr; ///< If set, overrides the global session cache
+	String sslSessionCacheKey;			  ///< "host:port" for client connections
 #endif
 	bool useSsl = false;
 
@@ -294,6 +314,7 @@ private:
 
 #ifdef ENABLE_SSL
 	void closeSsl();
+	void storeSslSession();
 #endif
 };
 
@@ -12,6 +12,44 @@
 
 uint16_t TcpServer::totalConnections = 0;
 
+TcpServer::~TcpServer()
+{
+#ifdef ENABLE_SSL
+	freeSslContext();
+#endif
+	debug_i("TcpServer destroyed");
+}
+
+#ifdef ENABLE_SSL
+void TcpServer::freeSslContext()
+{
+	if(sslContext == nullptr) {
+		return;
+	}
+
+	/*
+	 * Freeing the context also frees the SSL object of every connection using it, which the connection
+	 * would then free again. Such connections cannot continue anyway so free them first. They're removed
+	 * from the list here, rather than by onClientDestroy(), which could delete the server part way through.
+	 */
+	for(int i = connections.count() - 1; i >= 0; --i) {
+		TcpConnection* connection = connections[i];
+		if(connection == nullptr || connection->getSsl() == nullptr) {
+			continue;
+		}
+
+		connections.removeElementAt(i);
+		connection->setDestroyedDelegate(nullptr);
+		debug_d("SSL: Freeing connection before server context is freed");
+		delete connection;
+	}
+
+	// Also releases the session cache
+	ssl_ctx_free(sslContext);
+	sslContext = nullptr;
+}
+#endif
+
 TcpConnection* TcpServer::createClient(tcp_pcb* clientTcp)
 {
 	debug_d("TCP Server createClient %sNULL\r\n", clientTcp ? "not" : "");
@@ -58,7 +96,9 @@ bool TcpServer::listen(int port, bool useSsl)
 		sslOptions |= SSL_DISPLAY_STATES | SSL_DISPLAY_BYTES | SSL_DISPLAY_CERTS;
 #endif
 
+		freeSslContext();
 		sslContext = ssl_ctx_new(sslOptions, sslSessionCacheSize);
+		debug_d("SSL: Server session cache size %d", sslSessionCacheSize);
 
 		if(!sslKeyCert.isValid()) {
 			debug_e("SSL: server certificate and key are not provided!");
@@ -25,6 +25,11 @@ typedef Delegate<void(TcpClient* client)> TcpClientConnectDelegate;
 // By default a TCP server will wait for a new remote client connection to get established for 20 seconds
 #define TCP_SERVER_TIMEOUT 20
 
+/// Number of SSL sessions a server retains so returning clients can skip the full handshake
+#ifndef SSL_SERVER_SESSION_CACHE_SIZE
+#define SSL_SERVER_SESSION_CACHE_SIZE 10
+#endif
+
 class TcpServer : public TcpConnection
 {
 public:
@@ -54,10 +59,7 @@ public:
 		TcpConnection::timeOut = TCP_SERVER_TIMEOUT;
 	}
 
-	~TcpServer()
-	{
-		debug_i("TcpServer destroyed");
-	}
+	~TcpServer();
 
 public:
 	virtual bool listen(int port, bool useSsl = false);
@@ -80,6 +82,17 @@ public:
 	 * @brief Adds SSL support and specifies the server certificate and private key.
 	 */
 	using TcpConnection::setSslKeyCert;
+
+	/**
+	 * @brief Set the number of SSL sessions to retain for resumption
+	 * @param size Setting this to 0 disables resumption
+	 * @note Must be called before `listen()`. Resuming a session avoids the public key operations
+	 * of a full handshake, which take several seconds on an ESP8266.
+	 */
+	void setSslSessionCacheSize(unsigned size)
+	{
+		sslSessionCacheSize = size;
+	}
 #endif
 
 protected:
@@ -95,13 +108,17 @@ protected:
 private:
 	static err_t staticAccept(void* arg, tcp_pcb* new_tcp, err_t err);
 
+#ifdef ENABLE_SSL
+	void freeSslContext();
+#endif
+
 public:
 	static uint16_t totalConnections; ///< @deprecated not updated by framework
 	uint16_t activeClients = 0;
 
 protected:
 #ifdef ENABLE_SSL
-	int sslSessionCacheSize = 50;
+	int sslSessionCacheSize = SSL_SERVER_SESSION_CACHE_SIZE;
 	size_t minHeapSize = 16384;
 #else
 	size_t minHeapSize = 3000;
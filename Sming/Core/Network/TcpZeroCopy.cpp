@@ -0,0 +1,64 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TcpZeroCopy.cpp
+ *
+ ****/
+
+#include "TcpZeroCopy.h"
+#include "Data/Stream/DataSourceStream.h"
+
+TcpZeroCopy::Entry* TcpZeroCopy::entries;
+
+void TcpZeroCopy::add(tcp_pcb* pcb, IDataSourceStream* stream)
+{
+	for(auto zc = entries; zc != nullptr; zc = zc->next) {
+		if(zc->pcb == pcb && zc->stream == stream) {
+			zc->endSeq = pcb->snd_lbb;
+			return;
+		}
+	}
+
+	entries = new Entry{entries, pcb, stream, pcb->snd_lbb, false};
+}
+
+void TcpZeroCopy::remove(tcp_pcb* pcb, bool aborted)
+{
+	auto prev = &entries;
+	while(*prev != nullptr) {
+		auto zc = *prev;
+		if(zc->pcb == pcb && (aborted || int32_t(pcb->lastack - zc->endSeq) >= 0)) {
+			*prev = zc->next;
+			if(zc->released) {
+				delete zc->stream;
+			}
+			delete zc;
+		} else {
+			prev = &zc->next;
+		}
+	}
+}
+
+bool TcpZeroCopy::pending(tcp_pcb* pcb)
+{
+	for(auto zc = entries; zc != nullptr; zc = zc->next) {
+		if(zc->pcb == pcb) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool TcpZeroCopy::release(IDataSourceStream* stream)
+{
+	for(auto zc = entries; zc != nullptr; zc = zc->next) {
+		if(zc->stream == stream) {
+			zc->released = true;
+			return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,56 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/anakod/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * TcpZeroCopy.h
+ *
+ ****/
+
+#pragma once
+
+#include "lwip/tcp.h"
+
+class IDataSourceStream;
+
+/** @brief Tracks streams whose memory is referenced by unacknowledged TCP segments following zero-copy writes
+ *
+ *  Entries are global as they must outlive the connection object: lwIP continues sending
+ *  queued data after the connection is closed by the application.
+ *
+ *  @see `TcpConnection::write(IDataSourceStream*)`
+ */
+class TcpZeroCopy
+{
+public:
+	/** @brief Record that stream memory has been queued, up to the connection's last buffered byte
+	 */
+	static void add(tcp_pcb* pcb, IDataSourceStream* stream);
+
+	/** @brief Remove acknowledged entries for a connection, deleting any released streams
+	 *  @param aborted true to remove all entries for the connection
+	 *  @note An aborted pcb has already been freed by lwIP so is not dereferenced
+	 */
+	static void remove(tcp_pcb* pcb, bool aborted);
+
+	/** @brief Determine if a connection has unacknowledged zero-copy data
+	 */
+	static bool pending(tcp_pcb* pcb);
+
+	/** @brief Mark a stream for deletion once acknowledged
+	 *  @retval bool false if the stream isn't referenced, so may be deleted immediately
+	 */
+	static bool release(IDataSourceStream* stream);
+
+private:
+	struct Entry {
+		Entry* next;
+		tcp_pcb* pcb;
+		IDataSourceStream* stream;
+		uint32_t endSeq; ///< Sequence number following the last byte referenced
+		bool released;   ///< Owner has finished with stream, delete once acknowledged
+	};
+
+	static Entry* entries;
+};
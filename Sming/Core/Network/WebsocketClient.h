@@ -13,8 +13,6 @@
  *
  ****/
 
-//TODO: Add stream support for sending big chunks of data via websockets.
-
 #pragma once
 
 #include "Http/HttpClientConnection.h"
@@ -60,6 +60,7 @@
 #include "Data/Stream/FileStream.h"
 #include "Data/Stream/TemplateFileStream.h"
 #include "Data/Stream/FlashMemoryStream.h"
+#include "Data/Stream/CompiledTemplateStream.h"
 
 #include "DateTime.h"
 
@@ -13,33 +13,95 @@
 
 SystemClockClass SystemClock;
 
-time_t SystemClockClass::now(TimeZone timeType)
+uint64_t SystemClockClass::getRtcUs()
 {
-	uint32_t systemTime = RTC.getRtcSeconds();
+	return RTC.getRtcNanoseconds() / 1000;
+}
+
+/*
+ * Apply as much of the outstanding adjustment as the slew rate allows for the time elapsed.
+ * The correction changes by less than the elapsed time, so the clock remains monotonic.
+ */
+void SystemClockClass::updateSlew(uint64_t rtcUs)
+{
+	if(slewRemainingUs == 0) {
+		slewTimeUs = rtcUs;
+		return;
+	}
+
+	uint64_t elapsed = rtcUs - slewTimeUs;
+	uint64_t maxStep = (elapsed * SYSTEM_CLOCK_SLEW_RATE_PPM) / 1000000;
+	if(maxStep == 0) {
+		// Don't update reference time so short intervals accumulate
+		return;
+	}
+
+	int32_t step = slewRemainingUs;
+	if(int64_t(step) > int64_t(maxStep)) {
+		step = maxStep;
+	} else if(int64_t(step) < -int64_t(maxStep)) {
+		step = -int32_t(maxStep);
+	}
+	correctionUs += step;
+	slewRemainingUs -= step;
+	slewTimeUs = rtcUs;
+}
+
+uint64_t SystemClockClass::nowUs(TimeZone timeType)
+{
+	uint64_t rtcUs = getRtcUs();
+	updateSlew(rtcUs);
+	uint64_t systemTime = rtcUs + correctionUs;
 
 	if(timeType == eTZ_UTC) {
-		systemTime -= timeZoneOffsetSecs;
+		systemTime -= int64_t(timeZoneOffsetSecs) * 1000000;
 	}
 
 	return systemTime;
 }
 
+bool SystemClockClass::stepTime(uint64_t timeUs)
+{
+	slewRemainingUs = 0;
+	if(RTC.setRtcNanoseconds(timeUs * 1000)) {
+		correctionUs = 0;
+	} else {
+		// RTC can't be set (e.g. Host emulator) so keep track of the difference instead
+		correctionUs = int64_t(timeUs - getRtcUs());
+	}
+	slewTimeUs = getRtcUs();
+	status = eSCS_Set;
+	return true;
+}
+
 bool SystemClockClass::setTime(time_t time, TimeZone timeType)
 {
 	if(timeType == eTZ_UTC) {
 		time += timeZoneOffsetSecs;
 	}
 
-	bool timeSet = RTC.setRtcSeconds(time);
-	if(timeSet) {
-		status = eSCS_Set;
-	}
+	bool timeSet = stepTime(uint64_t(uint32_t(time)) * 1000000);
 
 	debugf("time updated? %d", timeSet);
 
 	return timeSet;
 }
 
+bool SystemClockClass::adjustTime(int64_t offsetUs)
+{
+	uint64_t rtcUs = getRtcUs();
+	updateSlew(rtcUs);
+
+	if(status != eSCS_Set || offsetUs > SYSTEM_CLOCK_SLEW_LIMIT_US || offsetUs < -SYSTEM_CLOCK_SLEW_LIMIT_US) {
+		debug_d("SystemClock: step %d ms", int(offsetUs / 1000));
+		return stepTime(rtcUs + correctionUs + offsetUs);
+	}
+
+	debug_d("SystemClock: slew %d us", int(offsetUs));
+	slewRemainingUs = offsetUs;
+	return true;
+}
+
 String SystemClockClass::getSystemTimeString(TimeZone timeType)
 {
 	DateTime dt(now(timeType));
@@ -33,6 +33,18 @@ enum SystemClockStatus {
 };
 /** @} */
 
+/** @brief Offsets up to this size are corrected gradually by adjustTime(), larger ones step the clock
+ *  @note Slewing 1 second at the default rate takes about 33 minutes
+ */
+#ifndef SYSTEM_CLOCK_SLEW_LIMIT_US
+#define SYSTEM_CLOCK_SLEW_LIMIT_US 1000000
+#endif
+
+/// Maximum rate at which the clock is slewed, in parts per million (the same as adjtime())
+#ifndef SYSTEM_CLOCK_SLEW_RATE_PPM
+#define SYSTEM_CLOCK_SLEW_RATE_PPM 500
+#endif
+
 /** @brief  System clock class
  *  @addtogroup systemclock
  *  @{
@@ -44,15 +56,51 @@ public:
      *  @param  timeType Time zone to use (UTC / local)
      *  @retval DateTime Current date and time
      */
-	time_t now(TimeZone timeType = eTZ_Local);
+	time_t now(TimeZone timeType = eTZ_Local)
+	{
+		return nowUs(timeType) / 1000000;
+	}
+
+	/** @brief  Get the current time with microsecond resolution
+     *  @param  timeType Time zone to use (UTC / local)
+     *  @retval uint64_t Microseconds since 00:00:00 1970-01-01
+     *  @note   Time never goes backwards whilst an adjustment is being slewed
+     */
+	uint64_t nowUs(TimeZone timeType = eTZ_Local);
 
 	/** @brief  Set the system clock's time
      *  @param  time Unix time to set clock to (quantity of seconds since 00:00:00 1970-01-01)
      *  @param  timeType Time zone of Unix time, i.e. is time provided as local or UTC?
-     *  @note   System time is always stored as local timezone time
+     *  @note   System time is always stored as local timezone time. The clock is stepped
+     *  and any adjustment in progress is cancelled.
      */
 	bool setTime(time_t time, TimeZone timeType = eTZ_Local);
 
+	/** @brief  Correct the system clock by a measured offset
+     *  @param  offsetUs Microseconds to add to the current time
+     *  @retval bool true on success
+     *  @note   If the clock has been set and the offset is within SYSTEM_CLOCK_SLEW_LIMIT_US then the
+     *  clock is run slightly fast or slow until the offset has been applied, otherwise it's stepped.
+     *  A new adjustment replaces any which is still in progress.
+     */
+	bool adjustTime(int64_t offsetUs);
+
+	/** @brief  Get the part of the last adjustment still to be applied
+     *  @retval int32_t Microseconds
+     */
+	int32_t getSlewRemaining()
+	{
+		updateSlew(getRtcUs());
+		return slewRemainingUs;
+	}
+
+	/** @brief  Determine if the clock has been set
+     */
+	bool isSet() const
+	{
+		return status == eSCS_Set;
+	}
+
 	/** @brief  Get current time as a string
      *  @param  timeType Time zone to present time as, i.e. return local or UTC time
      *  @retval String Current time in format: dd.mm.yy hh:mm:ss
@@ -78,9 +126,17 @@ public:
 		return timeZoneOffsetSecs;
 	}
 
+private:
+	uint64_t getRtcUs();
+	void updateSlew(uint64_t rtcUs);
+	bool stepTime(uint64_t timeUs);
+
 private:
 	int timeZoneOffsetSecs = 0;
 	SystemClockStatus status = eSCS_Initial;
+	int64_t correctionUs = 0;	 ///< Applied to RTC time, accumulates slew and steps if RTC can't be set
+	int32_t slewRemainingUs = 0; ///< Adjustment yet to be applied
+	uint64_t slewTimeUs = 0;	 ///< RTC time when slew was last updated
 };
 
 /**	@brief	Global instance of system clock object
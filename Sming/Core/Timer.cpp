@@ -9,6 +9,7 @@
  ****/
 
 #include "Timer.h"
+#include "Services/Profiling/EventProfiler.h"
 
 Timer& Timer::initializeMs(uint32_t milliseconds, InterruptCallback callback)
 {
@@ -174,6 +175,7 @@ void Timer::processing()
 
 void Timer::tick()
 {
+	PROFILE_EVENT(TIMER, this);
 	if(callback) {
 		callback();
 	} else if(delegateFunc) {
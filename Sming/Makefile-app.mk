@@ -72,8 +72,30 @@ endif
 CONFIG_VARS	+= COM_SPEED_SERIAL
 CFLAGS		+= -DCOM_SPEED_SERIAL=$(COM_SPEED_SERIAL)
 
+# => Compiled templates, see CompiledTemplateStream
+CONFIG_VARS		+= TEMPLATE_FILES TEMPLATE_OUT
+TEMPLATE_FILES	?=
+TEMPLATE_OUT	?= out/templates
+TEMPLATE_BINS	:= $(foreach f,$(TEMPLATE_FILES),$(TEMPLATE_OUT)/$(notdir $f).bin)
+CUSTOM_TARGETS	+= $(TEMPLATE_BINS)
+
 include $(ARCH_BASE)/app.mk
 
+define CompileTemplate
+$(TEMPLATE_OUT)/$(notdir $1).bin: $1
+	$(vecho) "TPL $$<"
+	$(Q) mkdir -p $$(@D)
+	$(Q) python $(SMING_HOME)/Tools/compile-template.py $$< $$@
+endef
+$(foreach f,$(TEMPLATE_FILES),$(eval $(call CompileTemplate,$f)))
+
+# IMPORT_FSTR uses an assembler .incbin which dependency generation doesn't see,
+# so objects importing templates must be told to wait for them, and rebuild when they change
+ifneq (,$(TEMPLATE_BINS))
+TEMPLATE_IMPORT_SRC	:= $(shell grep -l IMPORT_FSTR $(wildcard $(addsuffix /*.cpp,$(MODULES))) /dev/null)
+$(patsubst %.cpp,$(BUILD_BASE)/%.o,$(patsubst $(SMING_HOME)/%,%,$(TEMPLATE_IMPORT_SRC))): $(TEMPLATE_BINS)
+endif
+
 #
 .PHONY: kill_term
 kill_term:
@@ -10,6 +10,7 @@
 
 #include "Platform/System.h"
 #include "SimpleTimer.h"
+#include "Services/Profiling/EventProfiler.h"
 
 SystemClass System;
 
@@ -31,6 +32,7 @@ void SystemClass::taskHandler(os_event_t* event)
 		--taskCount;
 		if(taskCount != oldCount - 1)
 			--taskCount;
+		PROFILE_EVENT(TASK, reinterpret_cast<const void*>(callback));
 		callback(event->par);
 	}
 }
@@ -56,7 +58,14 @@ bool SystemClass::queueCallback(TaskCallback callback, uint32_t param)
 		maxTaskCount = taskCount;
 	}
 
-	return system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback), param);
+	if(!system_os_post(USER_TASK_PRIO_1, reinterpret_cast<os_signal_t>(callback), param)) {
+#ifdef ENABLE_EVENT_PROFILER
+		EventProfiler::taskQueueOverflow();
+#endif
+		return false;
+	}
+
+	return true;
 }
 
 void SystemClass::onReady(SystemReadyDelegate readyHandler)
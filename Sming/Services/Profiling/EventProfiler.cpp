@@ -0,0 +1,139 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * EventProfiler.cpp
+ *
+ ****/
+
+#include "EventProfiler.h"
+#include "Platform/System.h"
+#include "Data/Stream/MemoryDataStream.h"
+#include "Network/Http/HttpResponse.h"
+
+EventProfiler::Stats EventProfiler::stats[EVENT_TYPE_MAX];
+EventProfiler::Trace EventProfiler::traces[EVENT_PROFILER_TRACE_SIZE];
+unsigned EventProfiler::traceCount;
+unsigned EventProfiler::traceIndex;
+unsigned EventProfiler::queueOverflows;
+uint32_t EventProfiler::slowThreshold = EVENT_PROFILER_SLOW_THRESHOLD;
+
+static const char* const eventTypeNames[] = {
+#define XX(tag, name) name,
+	EVENT_TYPE_MAP(XX)
+#undef XX
+};
+
+static unsigned getBucket(uint32_t duration)
+{
+	unsigned bucket = 0;
+	duration >>= EVENT_PROFILER_BUCKET_SHIFT;
+	while(duration != 0 && bucket < EVENT_PROFILER_BUCKETS - 1) {
+		duration >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+void EventProfiler::record(EventType type, const void* source, uint32_t duration)
+{
+	if(type >= EVENT_TYPE_MAX) {
+		return;
+	}
+
+	auto& s = stats[type];
+	++s.count;
+	s.totalTime += duration;
+	if(duration > s.maxTime) {
+		s.maxTime = duration;
+		s.maxSource = source;
+	}
+	++s.histogram[getBucket(duration)];
+
+	if(duration < slowThreshold) {
+		return;
+	}
+
+	debug_w("[PROF] Slow %s %p took %u us", eventTypeNames[type], source, duration);
+
+	traces[traceIndex] = Trace{millis(), duration, source, type};
+	traceIndex = (traceIndex + 1) % EVENT_PROFILER_TRACE_SIZE;
+	if(traceCount < EVENT_PROFILER_TRACE_SIZE) {
+		++traceCount;
+	}
+}
+
+const EventProfiler::Trace& EventProfiler::getTrace(unsigned index)
+{
+	// traceIndex is where the next entry goes, so once the buffer is full it's also the oldest
+	unsigned start = (traceCount < EVENT_PROFILER_TRACE_SIZE) ? 0 : traceIndex;
+	return traces[(start + index) % EVENT_PROFILER_TRACE_SIZE];
+}
+
+void EventProfiler::reset()
+{
+	memset(stats, 0, sizeof(stats));
+	traceCount = 0;
+	traceIndex = 0;
+	queueOverflows = 0;
+}
+
+String EventProfiler::getTypeName(EventType type)
+{
+	return (type < EVENT_TYPE_MAX) ? eventTypeNames[type] : nullptr;
+}
+
+size_t EventProfiler::printTo(Print& p)
+{
+	char buf[128];
+	size_t n = 0;
+
+	m_snprintf(buf, sizeof(buf), "Task queue: %u/%u peak, %u overflows\r\n", System.getMaxTaskCount(),
+			   TASK_QUEUE_LENGTH, queueOverflows);
+	n += p.print(buf);
+
+	for(unsigned type = 0; type < EVENT_TYPE_MAX; ++type) {
+		auto& s = stats[type];
+		m_snprintf(buf, sizeof(buf), "%s: count %u, avg %u us, max %u us (%p)\r\n", eventTypeNames[type], s.count,
+				   s.count ? s.totalTime / s.count : 0, s.maxTime, s.maxSource);
+		n += p.print(buf);
+		if(s.count == 0) {
+			continue;
+		}
+
+		for(unsigned i = 0; i < EVENT_PROFILER_BUCKETS; ++i) {
+			if(s.histogram[i] == 0) {
+				continue;
+			}
+			auto limit = getBucketLimit(i);
+			if(limit == UINT32_MAX) {
+				m_snprintf(buf, sizeof(buf), "  >= %u us: %u\r\n", getBucketLimit(i - 1), s.histogram[i]);
+			} else {
+				m_snprintf(buf, sizeof(buf), "  < %u us: %u\r\n", limit, s.histogram[i]);
+			}
+			n += p.print(buf);
+		}
+	}
+
+	m_snprintf(buf, sizeof(buf), "Slow events (>= %u us):\r\n", slowThreshold);
+	n += p.print(buf);
+	for(unsigned i = 0; i < traceCount; ++i) {
+		auto& trace = getTrace(i);
+		m_snprintf(buf, sizeof(buf), "  @%u ms %s %p: %u us\r\n", trace.timestamp, eventTypeNames[trace.type],
+				   trace.source, trace.duration);
+		n += p.print(buf);
+	}
+
+	return n;
+}
+
+void EventProfiler::onHttpRequest(HttpRequest& request, HttpResponse& response)
+{
+	(void)request;
+	auto stream = new MemoryDataStream;
+	printTo(*stream);
+	response.headers[HTTP_HEADER_CACHE_CONTROL] = "no-cache";
+	response.sendDataStream(stream, MIME_TEXT);
+}
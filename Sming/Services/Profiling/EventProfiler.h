@@ -0,0 +1,197 @@
+/****
+ * Sming Framework Project - Open Source framework for high efficiency native ESP8266 development.
+ * Created 2015 by Skurydin Alexey
+ * http://github.com/SmingHub/Sming
+ * All files of the Sming Core are provided under the LGPL v3 license.
+ *
+ * EventProfiler.h - Record execution time of task, timer and network callbacks
+ *
+ ****/
+
+#pragma once
+
+#include "ElapseTimer.h"
+#include "WString.h"
+
+class Print;
+class HttpRequest;
+class HttpResponse;
+
+/*
+ * Profiling is opt-in: build with ENABLE_EVENT_PROFILER=1 to instrument the framework callback
+ * dispatchers. Otherwise PROFILE_EVENT() compiles to nothing and no statistics are collected.
+ *
+ * Each event type keeps a count, total and maximum execution time plus a log2 histogram.
+ * Any callback taking longer than the slow threshold is logged and added to a small trace buffer,
+ * identified by its source address (callback, Timer, TcpConnection or HttpResource) which can be
+ * looked up in the application map file.
+ *
+ * Note that nested events are timed independently, so TCP receive times include any HTTP handler
+ * invoked from within them.
+ */
+
+/// Number of slow events retained in the trace buffer
+#ifndef EVENT_PROFILER_TRACE_SIZE
+#define EVENT_PROFILER_TRACE_SIZE 8
+#endif
+
+/// Default time in microseconds above which an event is considered slow
+#ifndef EVENT_PROFILER_SLOW_THRESHOLD
+#define EVENT_PROFILER_SLOW_THRESHOLD 20000
+#endif
+
+/// Histogram bucket 0 counts events under 16us, each subsequent bucket doubles the range
+#define EVENT_PROFILER_BUCKETS 12
+#define EVENT_PROFILER_BUCKET_SHIFT 4
+
+/**
+ * @brief Event types which are profiled
+ */
+#define EVENT_TYPE_MAP(XX)                                                                                             \
+	XX(TASK, "Task")                                                                                                   \
+	XX(TIMER, "Timer")                                                                                                 \
+	XX(TCP_RECEIVE, "TCP receive")                                                                                     \
+	XX(TCP_SENT, "TCP sent")                                                                                           \
+	XX(TCP_POLL, "TCP poll")                                                                                           \
+	XX(HTTP_HANDLER, "HTTP handler")
+
+enum EventType {
+#define XX(tag, name) EVENT_TYPE_##tag,
+	EVENT_TYPE_MAP(XX)
+#undef XX
+		EVENT_TYPE_MAX
+};
+
+class EventProfiler
+{
+public:
+	struct Stats {
+		uint32_t count;
+		uint32_t totalTime;		 ///< Microseconds, wraps after about 71 minutes of callback execution
+		uint32_t maxTime;		 ///< Longest execution time in microseconds
+		const void* maxSource; ///< Source of the longest event
+		uint32_t histogram[EVENT_PROFILER_BUCKETS];
+	};
+
+	struct Trace {
+		uint32_t timestamp; ///< millis() when the event completed
+		uint32_t duration;  ///< Microseconds
+		const void* source;
+		EventType type;
+	};
+
+	/**
+	 * @brief Measures the lifetime of a scope as a single event
+	 */
+	class Scope
+	{
+	public:
+		Scope(EventType type, const void* source) : type(type), source(source)
+		{
+		}
+
+		~Scope()
+		{
+			record(type, source, timer.elapsed());
+		}
+
+	private:
+		ElapseTimer timer;
+		EventType type;
+		const void* source;
+	};
+
+	/**
+	 * @brief Add an event to the statistics
+	 * @param type
+	 * @param source Identifies the callback, used to locate slow handlers
+	 * @param duration Execution time in microseconds
+	 */
+	static void record(EventType type, const void* source, uint32_t duration);
+
+	/**
+	 * @brief Note that a task could not be queued because the queue was full
+	 */
+	static void taskQueueOverflow()
+	{
+		++queueOverflows;
+	}
+
+	static const Stats& getStats(EventType type)
+	{
+		return stats[type];
+	}
+
+	static unsigned getQueueOverflows()
+	{
+		return queueOverflows;
+	}
+
+	/**
+	 * @brief Get number of slow events in the trace buffer
+	 */
+	static unsigned getTraceCount()
+	{
+		return traceCount;
+	}
+
+	/**
+	 * @brief Get a slow event from the trace buffer
+	 * @param index 0 is the oldest event
+	 */
+	static const Trace& getTrace(unsigned index);
+
+	static void setSlowThreshold(uint32_t microseconds)
+	{
+		slowThreshold = microseconds;
+	}
+
+	static uint32_t getSlowThreshold()
+	{
+		return slowThreshold;
+	}
+
+	/**
+	 * @brief Clear all statistics and traces
+	 */
+	static void reset();
+
+	static String getTypeName(EventType type);
+
+	/**
+	 * @brief Get the upper time limit for a histogram bucket
+	 * @param bucket
+	 * @retval uint32_t Microseconds, UINT32_MAX for the last bucket
+	 */
+	static uint32_t getBucketLimit(unsigned bucket)
+	{
+		return (bucket + 1 < EVENT_PROFILER_BUCKETS) ? (1U << (bucket + EVENT_PROFILER_BUCKET_SHIFT)) : UINT32_MAX;
+	}
+
+	/**
+	 * @brief Write a text report of all statistics, e.g. to Serial
+	 */
+	static size_t printTo(Print& p);
+
+	/**
+	 * @brief Send report as an HTTP response
+	 * @note Compatible with HttpPathDelegate, e.g. `server.paths.set("/profile", EventProfiler::onHttpRequest);`
+	 */
+	static void onHttpRequest(HttpRequest& request, HttpResponse& response);
+
+private:
+	static Stats stats[EVENT_TYPE_MAX];
+	static Trace traces[EVENT_PROFILER_TRACE_SIZE];
+	static unsigned traceCount;
+	static unsigned traceIndex;
+	static unsigned queueOverflows;
+	static uint32_t slowThreshold;
+};
+
+#ifdef ENABLE_EVENT_PROFILER
+#define PROFILE_EVENT(type, source) EventProfiler::Scope eventProfilerScope(EVENT_TYPE_##type, source)
+#else
+#define PROFILE_EVENT(type, source)                                                                                    \
+	do {                                                                                                               \
+	} while(0)
+#endif
@@ -0,0 +1,116 @@
+#!/usr/bin/env python
+########################################################
+#
+#  Template Compiler
+#
+#  Pre-splits a template into literal and variable segments for use with
+#  CompiledTemplateStream. Variables are recognised using the same rules as
+#  TemplateStream: {name}, without whitespace or braces.
+#
+#  Output is little-endian and word-aligned, for binding into flash with IMPORT_FSTR:
+#
+#    Header     uint32 magic, uint16 varCount, uint16 segmentCount
+#    Variables  uint32 hash, uint16 nameOffset, uint16 nameLength (sorted by hash)
+#    Segments   uint32 offset, uint16 length, uint16 varIndex (0xFFFF for literal text)
+#    Text       Variable names (each within braces) followed by literal text
+#
+########################################################
+import re
+import struct
+import sys
+
+MAGIC = 0x4C504D54 # "TMPL"
+LITERAL = 0xFFFF
+MAX_VAR_NAME_LEN = 15 # As TemplateStream, see TEMPLATE_MAX_VAR_NAME_LEN
+MAX_SEGMENT_LEN = 0xFFFF
+
+HEADER_SIZE = 8
+VAR_SIZE = 8
+SEGMENT_SIZE = 8
+
+def usage():
+    print("Usage: \n\t%s <template> <output.bin>" % sys.argv[0])
+
+# 32-bit FNV-1a, must match CompiledTemplateStream
+def hashName(name):
+    h = 0x811C9DC5
+    for c in bytearray(name):
+        h = ((h ^ c) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+def parse(content):
+    pattern = re.compile(b"\\{([^\\s{}]{1,%u})\\}" % MAX_VAR_NAME_LEN)
+    segments = []
+    pos = 0
+    for m in pattern.finditer(content):
+        if m.start() > pos:
+            segments.append((False, content[pos:m.start()]))
+        segments.append((True, m.group(1)))
+        pos = m.end()
+    if pos < len(content):
+        segments.append((False, content[pos:]))
+    return segments
+
+def compileTemplate(content):
+    segments = parse(content)
+
+    names = sorted(set(name for isVar, name in segments if isVar), key=lambda n: (hashName(n), n))
+    varIndex = dict((name, i) for i, name in enumerate(names))
+
+    # Split long literals so lengths fit the segment table
+    splitSegments = []
+    for isVar, data in segments:
+        if isVar:
+            splitSegments.append((isVar, data))
+            continue
+        for i in range(0, len(data), MAX_SEGMENT_LEN):
+            splitSegments.append((isVar, data[i:i + MAX_SEGMENT_LEN]))
+    segments = splitSegments
+
+    if len(names) >= LITERAL or len(segments) > 0xFFFF:
+        raise ValueError("Template too complex")
+
+    textOffset = HEADER_SIZE + len(names) * VAR_SIZE + len(segments) * SEGMENT_SIZE
+    text = bytearray()
+
+    varTable = bytearray()
+    for name in names:
+        text += b"{"
+        nameOffset = textOffset + len(text)
+        if nameOffset + len(name) > 0xFFFF:
+            raise ValueError("Too many variables")
+        varTable += struct.pack("<IHH", hashName(name), nameOffset, len(name))
+        text += name + b"}"
+
+    segmentTable = bytearray()
+    for isVar, data in segments:
+        if isVar:
+            segmentTable += struct.pack("<IHH", 0, 0, varIndex[data])
+        else:
+            segmentTable += struct.pack("<IHH", textOffset + len(text), len(data), LITERAL)
+            text += data
+
+    output = struct.pack("<IHH", MAGIC, len(names), len(segments)) + varTable + segmentTable + text
+    return output, len(names), len(segments)
+
+def main():
+    if len(sys.argv) != 3:
+        usage()
+        sys.exit(1)
+
+    with open(sys.argv[1], "rb") as f:
+        content = f.read()
+
+    try:
+        output, varCount, segmentCount = compileTemplate(content)
+    except ValueError as e:
+        print("%s: %s" % (sys.argv[1], e))
+        sys.exit(1)
+
+    with open(sys.argv[2], "wb") as f:
+        f.write(output)
+
+    print("%s: %u variables, %u segments, %u bytes" % (sys.argv[1], varCount, segmentCount, len(output)))
+
+if __name__ == "__main__":
+    main()
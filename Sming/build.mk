@@ -129,6 +129,13 @@ ifeq ($(ENABLE_GDB), 1)
 	CFLAGS += -ggdb -DENABLE_GDB=1
 endif
 
+# Profile task, timer and network callbacks (see Services/Profiling/EventProfiler.h)
+# Sming must be rebuilt if this is changed
+CONFIG_VARS += ENABLE_EVENT_PROFILER
+ifeq ($(ENABLE_EVENT_PROFILER), 1)
+	CFLAGS += -DENABLE_EVENT_PROFILER=1
+endif
+
 CONFIG_VARS += SMING_RELEASE
 ifeq ($(SMING_RELEASE),1)
 	# See: https://gcc.gnu.org/onlinedocs/gcc/Optimize-Options.html
@@ -7,3 +7,6 @@ DISABLE_SPIFFS = 1
 
 DEBUG_VERBOSE_LEVEL = 3
 SPI_SIZE = 4M
+
+## Compiled templates
+TEMPLATE_FILES = resource/template.html
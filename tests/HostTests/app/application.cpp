@@ -2,6 +2,18 @@
 
 extern void test_json();
 extern void test_files();
+extern void test_timers();
+extern void test_http();
+extern void test_pool();
+extern void test_delegate();
+extern void test_clock();
+extern void test_websocket();
+extern void test_template();
+extern void test_sha256();
+extern void test_tcp();
+extern void test_ftp();
+extern void test_ssl();
+extern void test_delta();
 
 void init()
 {
@@ -11,6 +23,18 @@ void init()
 
 	test_json();
 	test_files();
+	test_timers();
+	test_http();
+	test_pool();
+	test_delegate();
+	test_clock();
+	test_websocket();
+	test_template();
+	test_sha256();
+	test_tcp();
+	test_ftp();
+	test_ssl();
+	test_delta();
 
 	system_restart();
 }
@@ -0,0 +1,62 @@
+#include "common.h"
+#include <Services/Profiling/ElapseTimer.h>
+
+void test_clock()
+{
+	startTest("NTP timestamp conversion");
+	{
+		const int64_t times[] = {0, 1, 999999, 1571400000123456LL, 2085978495999999LL, 2085978496000000LL};
+		for(auto time : times) {
+			uint64_t timestamp = NtpClient::unixUsToNtp(time);
+			int64_t result = NtpClient::ntpToUnixUs(timestamp);
+			debug_i("%u.%06u -> 0x%08x%08x", uint32_t(time / 1000000), uint32_t(time % 1000000),
+					uint32_t(timestamp >> 32), uint32_t(timestamp));
+			assert(result == time);
+		}
+
+		// 2036-02-07 06:28:16 UTC is the start of NTP era 1
+		assert(NtpClient::ntpToUnixUs(0) == 2085978496000000LL);
+		// Half a second
+		assert(NtpClient::ntpToUnixUs((uint64_t(NTP_UNIX_EPOCH_OFFSET) << 32) | 0x80000000U) == 500000);
+	}
+
+	startTest("SystemClock adjustment");
+	{
+		const time_t testTime = 1571400000;
+		SystemClock.setTime(testTime, eTZ_UTC);
+		assert(SystemClock.isSet());
+		auto now = SystemClock.now(eTZ_UTC);
+		assert(now == testTime || now == testTime + 1);
+
+		// Small offsets are slewed, and time never goes backwards
+		for(int offset : {2000, -2000}) {
+			assert(SystemClock.adjustTime(offset));
+			assert(SystemClock.getSlewRemaining() == offset);
+
+			const uint32_t period = 200000;
+			uint64_t start = SystemClock.nowUs();
+			uint64_t last = start;
+			ElapseTimer elapse;
+			while(elapse.elapsed() < period) {
+				uint64_t t = SystemClock.nowUs();
+				assert(t >= last);
+				last = t;
+			}
+
+			// Slewed by no more than the maximum rate
+			int applied = offset - SystemClock.getSlewRemaining();
+			int maxApplied = (period * 2 * SYSTEM_CLOCK_SLEW_RATE_PPM) / 1000000;
+			debug_i("Slew %d us, applied %d us in %u us", offset, applied, uint32_t(last - start));
+			assert(applied != 0);
+			assert(abs(applied) <= maxApplied);
+		}
+
+		// Large offsets step the clock
+		uint64_t before = SystemClock.nowUs();
+		assert(SystemClock.adjustTime(-5000000));
+		assert(SystemClock.getSlewRemaining() == 0);
+		int64_t diff = int64_t(SystemClock.nowUs() - before);
+		debug_i("Stepped clock by %d ms", int(diff / 1000));
+		assert(diff < -4900000 && diff > -5000000);
+	}
+}
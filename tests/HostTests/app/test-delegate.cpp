@@ -0,0 +1,107 @@
+#include "common.h"
+#include <Services/Profiling/ElapseTimer.h>
+#include <functional>
+
+namespace
+{
+class Counter
+{
+public:
+	void increment(unsigned value)
+	{
+		total += value;
+	}
+
+	unsigned total = 0;
+};
+
+// Lambda capture too large to be stored inline, so the delegate allocates a reference-counted caller
+struct LargeCapture {
+	unsigned values[8];
+};
+
+template <typename Factory> void benchmark(const char* name, Factory make, Counter& counter)
+{
+	const unsigned iterations = 100000;
+	auto callback = make();
+	using Callback = decltype(callback);
+
+	counter.total = 0;
+	ElapseTimer elapse;
+	for(unsigned i = 0; i < iterations; ++i) {
+		callback(1);
+	}
+	auto invokeTime = elapse.elapsed();
+	assert(counter.total == iterations);
+
+	elapse.start();
+	for(unsigned i = 0; i < iterations; ++i) {
+		Callback copy(callback);
+		copy(1);
+	}
+	auto copyTime = elapse.elapsed();
+	assert(counter.total == 2 * iterations);
+
+	elapse.start();
+	for(unsigned i = 0; i < iterations; ++i) {
+		make()(1);
+	}
+	auto constructTime = elapse.elapsed();
+	assert(counter.total == 3 * iterations);
+
+	debug_i("%s: %u x invoke %u us, copy + invoke %u us, construct + invoke %u us", name, iterations, invokeTime,
+			copyTime, constructTime);
+}
+
+} // namespace
+
+void test_delegate()
+{
+	using Callback = Delegate<void(unsigned)>;
+	Counter counter;
+
+	startTest("Delegate storage");
+	{
+		Callback method(&Counter::increment, &counter);
+		Callback lambda([&counter](unsigned value) { counter.total += value; });
+		LargeCapture large = {};
+		Callback largeLambda([&counter, large](unsigned value) { counter.total += value + large.values[0]; });
+
+		debug_i("sizeof(Delegate) = %u", sizeof(Callback));
+		assert(method && !method.isAllocated());
+		assert(lambda && !lambda.isAllocated());
+		assert(largeLambda && largeLambda.isAllocated());
+
+		Callback copy(largeLambda);
+		copy = method;
+		copy(2);
+		lambda(3);
+		largeLambda(4);
+		assert(counter.total == 9);
+
+		Callback moved(std::move(copy));
+		assert(!copy && moved);
+	}
+
+	startTest("Delegate performance");
+	{
+		benchmark("Inline method delegate", [&]() { return Callback(&Counter::increment, &counter); }, counter);
+		benchmark("Inline lambda delegate",
+				  [&]() { return Callback([&counter](unsigned value) { counter.total += value; }); }, counter);
+
+		// Equivalent to the previous implementation, which allocated a caller for every delegate
+		LargeCapture large = {};
+		benchmark("Allocated delegate",
+				  [&]() {
+					  return Callback([&counter, large](unsigned value) { counter.total += value + large.values[0]; });
+				  },
+				  counter);
+
+		benchmark("std::function",
+				  [&]() {
+					  return std::function<void(unsigned)>(
+						  std::bind(&Counter::increment, &counter, std::placeholders::_1));
+				  },
+				  counter);
+	}
+}
@@ -0,0 +1,161 @@
+#include "common.h"
+#include <Data/DeltaPatch.h>
+
+/*
+ * Patch made with Sming/Arch/Esp8266/Tools/rboot-delta.py from the images built by makeImages().
+ * It contains every record type, and arguments long enough to need a varint.
+ */
+static const uint8_t testPatch[] = {
+	0x53, 0x44, 0x4c, 0x54, 0xd0, 0x07, 0x00, 0x00, 0x40, 0x06, 0x00, 0x00, 0x1b, 0x37, 0xc1, 0xad,
+	0x83, 0x20, 0x8f, 0x03, 0xb4, 0x1c, 0x54, 0xe2, 0x82, 0xd4, 0x30, 0xae, 0xda, 0xb4, 0x58, 0x84,
+	0x39, 0x1f, 0x28, 0xd9, 0x70, 0x53, 0x63, 0x87, 0x1c, 0x3d, 0x05, 0x16, 0x05, 0x94, 0x80, 0xbe,
+	0x47, 0x6c, 0x99, 0x39, 0x69, 0xc8, 0x0d, 0x4b, 0x5e, 0x64, 0x49, 0x93, 0xc9, 0x6a, 0xf7, 0x5c,
+	0x5d, 0x00, 0x1b, 0xbe, 0x15, 0x44, 0x1e, 0x6c, 0x8f, 0xfe, 0x3a, 0xde, 0x7f, 0x45, 0xef, 0x91,
+	0x5e, 0x25, 0x10, 0xae, 0x61, 0x3d, 0xab, 0x20, 0x1d, 0xcb, 0xca, 0xd7, 0xea, 0xbc, 0x0b, 0x98,
+	0xa0, 0x23, 0x2d, 0x99, 0x08, 0x41, 0x5e, 0xdf, 0x05, 0x36, 0x42, 0x58, 0x82, 0x83, 0xc3, 0xb8,
+	0x1b, 0x47, 0x9b, 0x14, 0x8b, 0x35, 0xa3, 0x3f, 0xd8, 0x58, 0xd9, 0xe8, 0x40, 0x86, 0x32, 0x70,
+	0xe1, 0xa5, 0x25, 0x8c, 0x2c, 0xa1, 0xf4, 0x9f, 0x08, 0x29, 0xb8, 0xd4, 0xc5, 0x2c, 0x34, 0xff,
+	0xc7, 0x17, 0x56, 0x31, 0xef, 0xcb, 0x8c, 0x1d, 0xc8, 0x60, 0xcd, 0x2e, 0x76, 0x9c, 0x62, 0x64,
+	0x5f, 0x31, 0x78, 0xf2, 0x96, 0xba, 0x67, 0x99, 0x0c, 0x74, 0xc0, 0xc2, 0x75, 0xbc, 0x19, 0x5e,
+	0xfb, 0x4c, 0x9f, 0x91, 0x09, 0x3f, 0xe5, 0x06, 0x9f, 0x98, 0x17, 0x3f, 0x13, 0x41, 0x01, 0x3f,
+	0x44, 0x41, 0x01, 0x3f, 0x44, 0x41, 0x01, 0x3f, 0x44, 0x41, 0x01, 0x3f, 0x44, 0x41, 0x01, 0x3f,
+	0x44, 0x41, 0x01, 0x3f, 0x12, 0x00,
+};
+
+#define SOURCE_SIZE 2000
+#define TARGET_SIZE 1600
+
+// Source is pseudo-random, target has new data at the start, then moved and altered parts of the source
+static void makeImages(uint8_t* source, uint8_t* target)
+{
+	uint32_t seed = 1;
+	auto next = [&]() -> uint8_t {
+		seed = seed * 1103515245 + 12345;
+		return seed >> 16;
+	};
+
+	for(unsigned i = 0; i < SOURCE_SIZE; ++i) {
+		source[i] = next();
+	}
+	for(unsigned i = 0; i < 100; ++i) {
+		target[i] = next();
+	}
+	memcpy(&target[100], &source[600], 900);
+	memcpy(&target[1000], &source[0], 600);
+	for(unsigned i = 1050; i < TARGET_SIZE; i += 100) {
+		++target[i];
+	}
+}
+
+// Applies a patch to an image in memory
+class TestPatch : public DeltaPatch
+{
+public:
+	TestPatch(const uint8_t* source) : source(source)
+	{
+	}
+
+	// Deliver the patch in pieces of the given size
+	bool apply(const uint8_t* patch, size_t length, size_t blockSize)
+	{
+		for(size_t pos = 0; pos < length; pos += blockSize) {
+			if(!write(&patch[pos], std::min(blockSize, length - pos))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	uint8_t target[TARGET_SIZE];
+	size_t targetLength = 0;
+
+protected:
+	bool readSource(uint32_t offset, uint8_t* buffer, size_t length) override
+	{
+		assert(offset + length <= SOURCE_SIZE);
+		memcpy(buffer, &source[offset], length);
+		return true;
+	}
+
+	bool writeTarget(const uint8_t* data, size_t length) override
+	{
+		assert(targetLength + length <= TARGET_SIZE);
+		memcpy(&target[targetLength], data, length);
+		targetLength += length;
+		return true;
+	}
+
+private:
+	const uint8_t* source;
+};
+
+void test_delta()
+{
+	uint8_t source[SOURCE_SIZE];
+	uint8_t target[TARGET_SIZE];
+	makeImages(source, target);
+
+	startTest("Delta patch apply");
+	{
+		for(size_t blockSize : {sizeof(testPatch), size_t(1), size_t(7), size_t(100)}) {
+			TestPatch patch(source);
+			bool ok = patch.apply(testPatch, sizeof(testPatch), blockSize);
+			debug_i("Block size %u, %u bytes written", blockSize, patch.targetLength);
+			assert(ok);
+			assert(patch.isFinished());
+			assert(patch.getSourceSize() == SOURCE_SIZE);
+			assert(patch.getTargetSize() == TARGET_SIZE);
+			assert(patch.targetLength == TARGET_SIZE);
+			assert(memcmp(patch.target, target, TARGET_SIZE) == 0);
+		}
+
+		// Nothing may follow the end of the patch
+		TestPatch patch(source);
+		assert(patch.apply(testPatch, sizeof(testPatch), sizeof(testPatch)));
+		assert(!patch.write(testPatch, 1));
+		assert(patch.isError() && !patch.isFinished());
+	}
+
+	startTest("Delta patch source hash mismatch");
+	{
+		// Nothing is written if the source isn't the image the patch was made from
+		uint8_t badSource[SOURCE_SIZE];
+		memcpy(badSource, source, SOURCE_SIZE);
+		++badSource[SOURCE_SIZE - 1];
+		TestPatch patch(badSource);
+		assert(!patch.apply(testPatch, sizeof(testPatch), 16));
+		assert(patch.isError());
+		assert(patch.targetLength == 0);
+	}
+
+	startTest("Delta patch target hash mismatch");
+	{
+		// Fails at the end, once the whole target has been written
+		uint8_t badPatch[sizeof(testPatch)];
+		memcpy(badPatch, testPatch, sizeof(testPatch));
+		++badPatch[DELTA_HEADER_SIZE - 1];
+		TestPatch patch(source);
+		assert(!patch.apply(badPatch, sizeof(badPatch), 16));
+		assert(patch.isError() && !patch.isFinished());
+		assert(patch.targetLength == TARGET_SIZE);
+	}
+
+	startTest("Delta patch format errors");
+	{
+		// Bad magic
+		uint8_t badPatch[sizeof(testPatch)];
+		memcpy(badPatch, testPatch, sizeof(testPatch));
+		badPatch[0] = 'X';
+		TestPatch patch(source);
+		assert(!patch.apply(badPatch, sizeof(badPatch), sizeof(badPatch)));
+		assert(patch.targetLength == 0);
+
+		// Varint arguments are limited to 4 bytes
+		const uint8_t longArgument[] = {0x3f, 0x80, 0x80, 0x80, 0x80, 0x01};
+		patch.reset();
+		assert(patch.write(testPatch, DELTA_HEADER_SIZE));
+		assert(!patch.write(longArgument, sizeof(longArgument)));
+		assert(patch.isError());
+		assert(patch.targetLength == 0);
+	}
+}
@@ -1,5 +1,10 @@
 #include "common.h"
 
+#ifdef ARCH_HOST
+#include <hostlib/flashmem.h>
+#include <unistd.h>
+#endif
+
 IMPORT_FSTR(testContent, "../../Readme.md");
 
 void test_files()
@@ -91,4 +96,42 @@ void test_files()
 	size = fileGetSize(testFileName);
 	debug_i("Actual file size = %d", size);
 	assert(size == 100);
+
+#ifdef ARCH_HOST
+	startTest("New flash image is erased");
+	{
+		// Swap in a new backing file, restoring the original afterwards
+		const char* flashFileName = host_flashmem_get_filename();
+		host_flashmem_cleanup();
+		DEFINE_FSTR_LOCAL(testFlashName, "test-flash.bin");
+		String testFlashFile = testFlashName;
+		unlink(testFlashFile.c_str());
+		FlashmemConfig config = {testFlashFile.c_str(), 0x10000};
+		bool ok = host_flashmem_init(config);
+		assert(ok);
+		assert(flashmem_get_size_bytes() == 0x10000);
+
+		uint32_t buffer[64];
+		flashmem_read(buffer, 0x8000, sizeof(buffer));
+		for(auto value : buffer) {
+			assert(value == 0xFFFFFFFF);
+		}
+
+		// No erase required before writing
+		uint32_t data[64];
+		for(unsigned i = 0; i < ARRAY_SIZE(data); ++i) {
+			data[i] = 0x01010101 * i;
+		}
+		res = flashmem_write(data, 0x8000, sizeof(data));
+		assert(size_t(res) == sizeof(data));
+		flashmem_read(buffer, 0x8000, sizeof(buffer));
+		assert(memcmp(buffer, data, sizeof(data)) == 0);
+
+		host_flashmem_cleanup();
+		unlink(testFlashFile.c_str());
+		config = {flashFileName, 0};
+		ok = host_flashmem_init(config);
+		assert(ok);
+	}
+#endif
 }
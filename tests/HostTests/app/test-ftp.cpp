@@ -0,0 +1,152 @@
+#include "common.h"
+#include <Network/Ftp/FtpServerConnection.h>
+#include <Network/Ftp/FtpDataStream.h>
+
+// Control connection which records commands and responses instead of acting on them
+class TestFtpConnection : public FtpServerConnection
+{
+public:
+	TestFtpConnection(tcp_pcb* pcb) : FtpServerConnection(nullptr, pcb)
+	{
+	}
+
+	using FtpServerConnection::createDataConnection;
+
+	// Deliver data as a chain of packets, split at the given positions
+	void receive(const char* data, std::initializer_list<unsigned> splits = {})
+	{
+		pbuf bufs[4] = {};
+		unsigned count = 0;
+		unsigned pos = 0;
+		unsigned length = strlen(data);
+		for(unsigned split : splits) {
+			bufs[count].payload = const_cast<char*>(&data[pos]);
+			bufs[count].len = split - pos;
+			bufs[count].next = &bufs[count + 1];
+			++count;
+			pos = split;
+		}
+		bufs[count].payload = const_cast<char*>(&data[pos]);
+		bufs[count].len = length - pos;
+		onReceive(&bufs[0]);
+	}
+
+	void onCommand(FtpCommand command, const char* cmd, const char* data) override
+	{
+		commands += String(unsigned(command)) + ':' + cmd + '|' + data + ';';
+	}
+
+	void response(int code, String text = "") override
+	{
+		responses += String(code) + ';';
+	}
+
+	String commands;
+	String responses;
+};
+
+// Data connection which counts bytes written instead of sending them
+class TestDataStream : public FtpDataStream
+{
+public:
+	using FtpDataStream::FtpDataStream;
+
+	bool connect(IPAddress addr, uint16_t port, bool useSsl, uint32_t sslOptions) override
+	{
+		return true;
+	}
+
+	int write(const char* data, int len, uint8_t apiflags = 0) override
+	{
+		written += len;
+		return len;
+	}
+
+	void complete()
+	{
+		completed = true;
+	}
+};
+
+void test_ftp()
+{
+	startTest("FTP command lookup");
+	{
+#define XX(verb) assert(FtpServerConnection::getCommand(#verb) == FTP_CMD_##verb);
+		FTP_COMMAND_MAP(XX)
+#undef XX
+
+		assert(FtpServerConnection::getCommand("") == FTP_CMD_UNKNOWN);
+		assert(FtpServerConnection::getCommand("RET") == FTP_CMD_UNKNOWN);
+		assert(FtpServerConnection::getCommand("RETRX") == FTP_CMD_UNKNOWN);
+		assert(FtpServerConnection::getCommand("XPWD") == FTP_CMD_UNKNOWN);
+		// Verbs are converted to upper case before lookup
+		assert(FtpServerConnection::getCommand("user") == FTP_CMD_UNKNOWN);
+	}
+
+	startTest("FTP command line splitting");
+	{
+		tcp_pcb pcb = {};
+		auto connection = new TestFtpConnection(&pcb);
+
+		auto check = [&](const char* commands, const char* responses) {
+			debug_i("Commands '%s', responses '%s'", connection->commands.c_str(), connection->responses.c_str());
+			assert(connection->commands == commands);
+			assert(connection->responses == responses);
+			connection->commands = nullptr;
+			connection->responses = nullptr;
+		};
+
+		connection->receive("user guest\r\n");
+		check("0:USER|guest;", "");
+
+		// Blank lines are ignored, and a bare LF also ends a line
+		connection->receive("\r\nPwd\r\n\nSITE chmod 644 a.txt\n");
+		check("4:PWD|;14:SITE|chmod 644 a.txt;", "");
+
+		// Lines split across packets, or sharing one
+		connection->receive("RETR file.txt\r\nNO", {2, 14});
+		check("9:RETR|file.txt;", "");
+		connection->receive("OP\r\n");
+		check("13:NOOP|;", "");
+
+		// Overlong commands are rejected without affecting the next one
+		String line;
+		line.setLength(MAX_FTP_CMD + 1);
+		memset(line.begin(), 'X', line.length());
+		line += "\r\nTYPE I\r\n";
+		connection->receive(line.c_str(), {100, MAX_FTP_CMD + 1});
+		check("7:TYPE|I;", "500;");
+
+		delete connection;
+	}
+
+	startTest("FTP transfer completes when all data is acknowledged");
+	{
+		tcp_pcb pcb = {};
+		auto connection = new TestFtpConnection(&pcb);
+		auto stream = new TestDataStream(connection);
+		connection->createDataConnection(stream);
+		assert(connection->responses == "150;");
+		connection->responses = nullptr;
+
+		// Acknowledgements before the transfer is complete
+		stream->write(nullptr, 1000);
+		stream->onSent(1000);
+		assert(connection->responses == "");
+
+		// Transfer complete, but some data still unacknowledged
+		stream->write(nullptr, 3000);
+		stream->complete();
+		stream->onSent(1000);
+		assert(connection->responses == "");
+		stream->onSent(1500);
+		assert(connection->responses == "");
+
+		stream->onSent(500);
+		assert(connection->responses == "226;");
+
+		delete stream;
+		delete connection;
+	}
+}
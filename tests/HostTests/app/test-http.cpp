@@ -0,0 +1,567 @@
+#include "common.h"
+#include <Network/Http/HttpHeaders.h>
+#include <Network/Http/HttpResourceTree.h>
+#include <Network/Http/HttpResponse.h>
+#include <Network/Http/HttpBodyParser.h>
+#include <Network/Http/HttpServerConnection.h>
+#include <Network/Http/HttpConnectionPool.h>
+#include <Network/Http/Websocket/WebsocketConnection.h>
+#include <Network/TcpZeroCopy.h>
+#include <Data/Stream/SharedMemoryStream.h>
+#include <Services/Profiling/ElapseTimer.h>
+
+// Server connection which captures responses instead of sending them
+class TestServerConnection : public HttpServerConnection
+{
+public:
+	using HttpServerConnection::HttpServerConnection;
+	using HttpServerConnection::write;
+
+	bool receive(String data)
+	{
+		return onTcpReceive(*this, data.begin(), data.length());
+	}
+
+	// Emulate acknowledgement of everything sent so far
+	void sent()
+	{
+		TcpZeroCopy::remove(tcp, false);
+		onReadyToSendData(eTCE_Sent);
+	}
+
+	// Send everything queued, then emulate acknowledgement of the last of it
+	void sendAll()
+	{
+		while(pending() != 0) {
+			sent();
+		}
+		TcpZeroCopy::remove(tcp, false);
+	}
+
+	// Number of streams waiting to be sent, including the active one
+	unsigned pending() const
+	{
+		return (stream != nullptr) + streamQueue.count();
+	}
+
+	IDataSourceStream* getStream()
+	{
+		return stream;
+	}
+
+	int write(const char* data, int len, uint8_t apiflags) override
+	{
+		output.concat(data, len);
+		return len;
+	}
+
+	String output;
+};
+
+// Client connection which queues requests without connecting
+class TestClientConnection : public HttpClientConnection
+{
+public:
+	bool connect(const String& host, int port, bool useSsl, uint32_t sslOptions) override
+	{
+		return true;
+	}
+
+	void queueRequests(unsigned count)
+	{
+		while(count-- != 0) {
+			send(new HttpRequest(Url("http://test/")));
+		}
+	}
+};
+
+class TestConnectionPool : public HttpConnectionPool
+{
+public:
+	// Run the idle check as if the timeout had passed for every connection
+	void expire()
+	{
+		for(auto& entry : entries) {
+			entry.lastUsed -= HTTP_CLIENT_IDLE_TIMEOUT * 1000U;
+		}
+		checkIdle();
+	}
+
+	TestClientConnection* get(const String& key)
+	{
+		return static_cast<TestClientConnection*>(getConnection(key));
+	}
+
+protected:
+	HttpClientConnection* createConnection() override
+	{
+		return new TestClientConnection();
+	}
+};
+
+static void echoPath(HttpRequest& request, HttpResponse& response)
+{
+	response.sendString(String('[') + request.uri.Path + ']');
+}
+
+void test_http()
+{
+	startTest("HTTP header field name lookup");
+	{
+		HttpHeaders headers;
+		assert(headers.fromString("Content-Type") == HTTP_HEADER_CONTENT_TYPE);
+		assert(headers.fromString("content-type") == HTTP_HEADER_CONTENT_TYPE);
+		assert(headers.fromString("WWW-AUTHENTICATE") == HTTP_HEADER_WWW_AUTHENTICATE);
+		assert(headers.fromString("Content-Typ") == HTTP_HEADER_UNKNOWN);
+		assert(headers.fromString("") == HTTP_HEADER_UNKNOWN);
+
+		// Every standard name must resolve to its own code
+		for(unsigned i = HTTP_HEADER_UNKNOWN + 1; i < HTTP_HEADER_CUSTOM; ++i) {
+			auto field = static_cast<HttpHeaderFieldName>(i);
+			String name = headers.toString(field);
+			assert(headers.fromString(name) == field);
+			name.toLowerCase();
+			assert(headers.fromString(name) == field);
+		}
+
+		headers["X-Custom"] = "1";
+		assert(headers.fromString("x-custom") == HTTP_HEADER_CUSTOM);
+		assert(headers["X-CUSTOM"] == "1");
+
+		const unsigned iterations = 10000;
+		const String name = "Sec-WebSocket-Protocol";
+		ElapseTimer elapse;
+		for(unsigned i = 0; i < iterations; ++i) {
+			(void)headers.fromString(name);
+		}
+		debug_i("%u field name lookups took %u us", iterations, elapse.elapsed());
+	}
+
+	startTest("HTTP header serialisation");
+	{
+		HttpHeaders headers;
+		headers[HTTP_HEADER_CONTENT_TYPE] = "text/html";
+		headers[HTTP_HEADER_CONTENT_LENGTH] = "1234";
+		headers["X-Custom"] = "value";
+
+		String expected;
+		for(unsigned i = 0; i < headers.count(); ++i) {
+			expected += headers[i];
+		}
+
+		String output = "HTTP/1.1 200 OK\r\n";
+		assert(headers.appendTo(output));
+		assert(output == "HTTP/1.1 200 OK\r\n" + expected);
+		assert(headers.getOutputLength() == expected.length());
+		debug_i("%s", output.c_str());
+	}
+
+	startTest("HTTP resource path matching");
+	{
+		HttpResourceTree tree;
+		auto root = new HttpResource;
+		auto device = new HttpResource;
+		auto deviceList = new HttpResource;
+		auto status = new HttpResource;
+		auto files = new HttpResource;
+		tree.set("/", root);
+		tree.set("/api/device/{id}", device);
+		tree.set("/api/device/list", deviceList);
+		tree.set("/api/{type}/status", status);
+		tree.set("/files/*", files);
+		tree.setDefault(new HttpResource);
+
+		HttpParams params;
+		assert(tree.match("/") == root);
+		assert(tree.match("/api/device/list") == deviceList);
+		assert(tree.match("/api/device/12", &params) == device);
+		assert(params["id"] == "12");
+		assert(tree.match("/api/sensor/status", &params) == status);
+		assert(params["type"] == "sensor");
+		assert(tree.match("/files/web/index.html") == files);
+		assert(tree.match("/api/device") == nullptr);
+		assert(tree.match("/unknown") == nullptr);
+
+		// Index must be rebuilt when paths change
+		tree.remove("/api/device/list");
+		assert(tree.match("/api/device/list", &params) == device);
+		assert(params["id"] == "list");
+
+		// Changes made via a map Value, remove followed by add leaves the count unchanged
+		tree["/"].remove();
+		auto other = new HttpResource;
+		tree["/other"] = other;
+		assert(tree.match("/") == nullptr);
+		assert(tree.match("/other") == other);
+		assert(tree.match("/files/web/index.html") == files);
+
+		for(unsigned i = 0; i < 50; ++i) {
+			tree.set(String("/api/endpoint") + i, new HttpResource);
+		}
+		const unsigned iterations = 10000;
+		const String path = "/api/endpoint49";
+		ElapseTimer elapse;
+		for(unsigned i = 0; i < iterations; ++i) {
+			(void)tree.match(path);
+		}
+		debug_i("%u path lookups with %u paths took %u us", iterations, tree.count(), elapse.elapsed());
+	}
+
+	startTest("HTTP server request pipelining");
+	{
+		HttpResourceTree tree;
+		tree.setDefault(HttpPathDelegate(echoPath));
+		// Connection is never opened, only needs somewhere to store callbacks
+		tcp_pcb pcb = {};
+		pcb.snd_buf = 0xFFFF;
+
+		auto connection = new TestServerConnection(&pcb);
+		connection->setResourceTree(&tree);
+
+		// Three requests, the second split across receives
+		bool ok = connection->receive(F("GET /one HTTP/1.1\r\n\r\nGET /two HTTP/1.1\r\nHo"));
+		assert(ok);
+		ok = connection->receive(F("st: test\r\n\r\nGET /three HTTP/1.1\r\n\r\n"));
+		assert(ok);
+		for(unsigned i = 0; i < 10; ++i) {
+			connection->sent();
+		}
+
+		int one = connection->output.indexOf(F("\r\n\r\n[/one]"));
+		int two = connection->output.indexOf(F("\r\n\r\n[/two]"));
+		int three = connection->output.indexOf(F("\r\n\r\n[/three]"));
+		debug_i("Responses at %d, %d, %d", one, two, three);
+		assert(one > 0 && two > one && three > two);
+		assert(connection->output.startsWith(F("HTTP/1.1 200 ")));
+		assert(connection->output.endsWith(F("[/three]")));
+		TcpZeroCopy::remove(&pcb, false);
+		delete connection;
+
+		// Requests which can't be queued whilst the response is sent abort the connection
+		connection = new TestServerConnection(&pcb);
+		connection->setResourceTree(&tree);
+		String data = F("GET /one HTTP/1.1\r\n\r\n");
+		while(data.length() <= HTTP_SERVER_PIPELINE_SIZE + 100) {
+			data += F("GET /next HTTP/1.1\r\n\r\n");
+		}
+		ok = connection->receive(data);
+		assert(!ok);
+		connection->sent();
+		connection->sent();
+		assert(connection->output.indexOf(F("[/one]")) > 0);
+		assert(connection->output.indexOf(F("[/next]")) < 0);
+		TcpZeroCopy::remove(&pcb, false);
+		delete connection;
+	}
+
+	startTest("HTTP content encoding negotiation");
+	{
+		fileSetContent("page.html", "<html></html>");
+		fileSetContent("page.html.gz", "gzip content");
+		fileSetContent("script.js.gz", "gzip content");
+		HttpResponse::clearFileCache();
+
+		HttpHeaders requestHeaders;
+		auto check = [&](const char* fileName, const char* acceptEncoding, unsigned code, const char* encoding) {
+			requestHeaders.clear();
+			if(acceptEncoding != nullptr) {
+				requestHeaders[HTTP_HEADER_ACCEPT_ENCODING] = acceptEncoding;
+			}
+			HttpResponse response;
+			response.requestHeaders = &requestHeaders;
+			response.sendFile(fileName);
+			debug_i("%s, Accept-Encoding: %s -> %u, Content-Encoding: %s", fileName, acceptEncoding ?: "(none)",
+					response.code, response.headers[HTTP_HEADER_CONTENT_ENCODING].c_str());
+			assert(response.code == code);
+			assert(response.headers[HTTP_HEADER_CONTENT_ENCODING] == encoding);
+			if(code == HTTP_STATUS_OK) {
+				assert(response.headers[HTTP_HEADER_VARY] == "Accept-Encoding");
+			}
+		};
+
+		check("page.html", nullptr, HTTP_STATUS_OK, "gzip");
+		check("page.html", "gzip, deflate, br", HTTP_STATUS_OK, "gzip");
+		check("page.html", "deflate", HTTP_STATUS_OK, "");
+		check("page.html", "gzip;q=0", HTTP_STATUS_OK, "");
+		check("page.html", "gzip;q=0.000", HTTP_STATUS_OK, "");
+		check("page.html", "gzip;q=0.001", HTTP_STATUS_OK, "gzip");
+		check("page.html", "GZIP;q=0.5, identity;q=0", HTTP_STATUS_OK, "gzip");
+		check("script.js", "identity", HTTP_STATUS_NOT_ACCEPTABLE, "");
+		check("script.js", "*", HTTP_STATUS_OK, "gzip");
+		check("missing.css", "gzip", HTTP_STATUS_NOT_FOUND, "");
+
+		// Misses aren't cached, so a file created later is found
+		fileSetContent("missing.css.gz", "gzip content");
+		check("missing.css", "gzip", HTTP_STATUS_OK, "gzip");
+		fileDelete("missing.css.gz");
+		HttpResponse::clearFileCache();
+
+		// Compressed variants are ignored when not allowed
+		{
+			HttpResponse response;
+			response.requestHeaders = &requestHeaders;
+			response.sendFile("page.html", false);
+			assert(response.code == HTTP_STATUS_OK);
+			assert(!response.headers.contains(HTTP_HEADER_CONTENT_ENCODING));
+			assert(!response.headers.contains(HTTP_HEADER_VARY));
+		}
+		{
+			HttpResponse response;
+			response.sendFile("script.js", false);
+			assert(response.code == HTTP_STATUS_NOT_FOUND);
+		}
+
+		fileDelete("page.html");
+		fileDelete("page.html.gz");
+		fileDelete("script.js.gz");
+		HttpResponse::clearFileCache();
+	}
+
+	startTest("Shared memory stream");
+	{
+		const char* content = "Broadcast frame content";
+		const size_t length = strlen(content);
+		auto frame = new SharedMemoryStream(length + 8);
+		assert(frame->isValid());
+		memcpy(frame->getData(), content, length);
+		assert(frame->setLength(length));
+		assert(!frame->setLength(length + 1));
+
+		// Each copy reads independently from the same memory
+		SharedMemoryStream* readers[4];
+		for(auto& reader : readers) {
+			reader = new SharedMemoryStream(*frame);
+		}
+		assert(frame->getRefCount() == 1 + ARRAY_SIZE(readers));
+		delete frame;
+		assert(readers[0]->getRefCount() == ARRAY_SIZE(readers));
+
+		const char* data;
+		assert(readers[0]->getMemoryBlock(data) == length);
+		assert(memcmp(data, content, length) == 0);
+		assert(readers[0]->seek(length));
+		assert(readers[0]->isFinished());
+		assert(!readers[0]->seek(1));
+
+		char buf[8];
+		assert(readers[1]->readMemoryBlock(buf, sizeof(buf)) == sizeof(buf));
+		assert(memcmp(buf, content, sizeof(buf)) == 0);
+		assert(readers[1]->available() == int(length));
+		assert(readers[1]->getMemoryBlock(data) == length);
+		assert(data == readers[2]->getData());
+
+		for(auto reader : readers) {
+			delete reader;
+		}
+	}
+
+	startTest("Websocket broadcast");
+	{
+		tcp_pcb pcb[2] = {};
+		TestServerConnection* connections[2];
+		WebsocketConnection* sockets[2];
+		for(unsigned i = 0; i < 2; ++i) {
+			pcb[i].snd_buf = 0xFFFF;
+			connections[i] = new TestServerConnection(&pcb[i]);
+			sockets[i] = new WebsocketConnection(connections[i], false);
+			sockets[i]->onConnected();
+		}
+
+		// Frame goes after data already queued, and before any which follows
+		connections[0]->sendString("first");
+		WebsocketConnection::broadcast("hello", 5);
+		connections[0]->sendString("last");
+		assert(connections[0]->pending() == 3);
+		assert(connections[1]->pending() == 1);
+
+		// Connections share one copy of the frame, released as each has sent it
+		auto frame = static_cast<SharedMemoryStream*>(connections[1]->getStream());
+		assert(frame->getRefCount() == 2);
+		connections[0]->sendAll();
+		assert(connections[0]->output == "first\x81\x05hellolast");
+		assert(frame->getRefCount() == 1);
+		connections[1]->sendAll();
+		assert(connections[1]->output == "\x81\x05hello");
+
+		// Payloads of 64K or more require the 64-bit extended length
+		const size_t length = 0x10000 + 100;
+		auto message = new char[length];
+		for(unsigned i = 0; i < length; ++i) {
+			message[i] = os_random();
+		}
+		WebsocketConnection::broadcast(message, length, WS_FRAME_BINARY);
+		for(auto connection : connections) {
+			connection->output = nullptr;
+			connection->sendAll();
+			const size_t headerLength = 10;
+			assert(connection->output.length() == headerLength + length);
+			auto data = reinterpret_cast<const uint8_t*>(connection->output.c_str());
+			assert(data[0] == 0x82);
+			assert(data[1] == 127);
+			assert(memcmp(&data[headerLength], message, length) == 0);
+		}
+		delete[] message;
+
+		for(unsigned i = 0; i < 2; ++i) {
+			delete sockets[i];
+			delete connections[i];
+		}
+	}
+
+	startTest("HTTP client connection pool");
+	{
+		TestConnectionPool pool;
+		auto& stats = pool.getStats();
+
+		// An idle connection to the same server is re-used
+		auto a1 = pool.get("a:80");
+		assert(a1 != nullptr);
+		assert(pool.get("a:80") == a1);
+		assert(stats.misses == 1 && stats.hits == 1);
+
+		// Busy connections are not, up to the per-host limit
+		a1->queueRequests(2);
+		auto a2 = pool.get("a:80");
+		assert(a2 != nullptr && a2 != a1);
+		assert(stats.misses == 2);
+
+		// Then requests queue on the connection with the fewest outstanding
+		a2->queueRequests(1);
+		assert(pool.get("a:80") == a2);
+		assert(stats.queued == 1);
+		assert(pool.count() == 2);
+
+		// Other servers have their own connections
+		auto b = pool.get("b:80");
+		assert(b != nullptr && b != a1 && b != a2);
+		auto c = pool.get("c:80");
+		assert(c != nullptr && c != b);
+		assert(pool.count() == HTTP_CLIENT_MAX_CONNECTIONS);
+		assert(stats.misses == 4 && stats.evictions == 0);
+
+		// A full pool closes the least recently used idle connection
+		assert(pool.get("d:80") != nullptr);
+		assert(pool.count() == HTTP_CLIENT_MAX_CONNECTIONS);
+		assert(stats.evictions == 1);
+		assert(pool.get("c:80") == c);
+		assert(stats.hits == 2);
+
+		// Idle connections time out, busy ones stay open
+		pool.expire();
+		assert(pool.count() == 2);
+		assert(stats.evictions == 3);
+		assert(pool.get("a:80") == a2);
+
+		pool.resetStats();
+		assert(stats.hits == 0 && stats.misses == 0 && stats.queued == 0 && stats.evictions == 0);
+		pool.clear();
+		assert(pool.count() == 0);
+	}
+
+	startTest("Form URL-encoded body parser");
+	{
+		const char* body = "name=J%C3%B6rg+Smith&empty=&flag&pct=100%25&bad=%zz%4&eq=a=b&x%3Dy=1&&=ignored&last=%41%2";
+		const unsigned bodyLength = strlen(body);
+
+		// Result must not depend on how the body is split into chunks
+		for(unsigned chunkSize = 1; chunkSize <= bodyLength; ++chunkSize) {
+			HttpRequest request;
+			formUrlParser(request, nullptr, PARSE_DATASTART);
+			for(unsigned pos = 0; pos < bodyLength; pos += chunkSize) {
+				formUrlParser(request, &body[pos], std::min(chunkSize, bodyLength - pos));
+			}
+			formUrlParser(request, nullptr, PARSE_DATAEND);
+			assert(request.args == nullptr);
+
+			auto& params = request.postParams;
+			if(chunkSize == 1) {
+				debug_i("Parsed %u fields: %s", params.count(), params.toString().c_str());
+			}
+			assert(params.count() == 8);
+			assert(params["name"] == "J\xc3\xb6rg Smith");
+			assert(params.contains("empty") && params["empty"].length() == 0);
+			assert(params.contains("flag") && params["flag"].length() == 0);
+			assert(params["pct"] == "100%");
+			assert(params["bad"] == "%zz%4");
+			assert(params["eq"] == "a=b");
+			assert(params["x=y"] == "1");
+			assert(params["last"] == "A%2");
+		}
+
+		// Limits
+		String longValue;
+		while(longValue.length() < HTTP_FORM_BUFFER_SIZE) {
+			longValue += 'x';
+		}
+		String data = "a=1&long=" + longValue + "&b=2";
+		for(unsigned i = 0; i < HTTP_FORM_MAX_FIELDS; ++i) {
+			data += "&f";
+			data += i;
+			data += "=1";
+		}
+
+		HttpRequest request;
+		formUrlParser(request, nullptr, PARSE_DATASTART);
+		formUrlParser(request, data.c_str(), data.length());
+		formUrlParser(request, nullptr, PARSE_DATAEND);
+		auto& params = request.postParams;
+		assert(params.count() == HTTP_FORM_MAX_FIELDS);
+		assert(params["a"] == "1");
+		assert(params["b"] == "2");
+		assert(!params.contains("long"));
+		assert(!params.contains(String("f") + (HTTP_FORM_MAX_FIELDS - 2)));
+	}
+
+	startTest("Multipart form data body parser");
+	{
+		// File content includes partial delimiter matches
+		String fileContent;
+		for(unsigned i = 0; i < 300; ++i) {
+			fileContent += char(i);
+		}
+		fileContent += "\r\n--XyZ\r\n-\r\r\n--XyZab!\r\n--Xy";
+
+		String body = "preamble\r\n--XyZabc\r\n";
+		body += "Content-Disposition: form-data; name=\"title\"\r\n\r\nMy Upload\r\n--XyZabc\r\n";
+		body += "Content-Disposition: form-data; name=\"file\"; filename=\"data.bin\"\r\n";
+		body += "Content-Type: application/octet-stream\r\n\r\n";
+		body += fileContent;
+		body += "\r\n--XyZabc\r\n";
+		body += "Content-Disposition: form-data; name=\"ignored\"; filename=\"other.bin\"\r\n\r\nxxx\r\n--XyZabc\r\n";
+		// Truncating this header would leave a valid field name, so the part must be discarded
+		String longHeader = "Content-Disposition: form-data; name=\"title\"; comment=\"";
+		while(longHeader.length() < HTTP_MULTIPART_HEADER_SIZE) {
+			longHeader += 'x';
+		}
+		body += longHeader + "\"\r\n\r\nReplaced\r\n--XyZabc\r\n";
+		body += "content-disposition: form-data; name=empty\r\n\r\n\r\n--XyZabc--\r\nepilogue";
+
+		for(unsigned chunkSize = 1; chunkSize <= body.length(); ++chunkSize) {
+			HttpRequest request;
+			request.headers[HTTP_HEADER_CONTENT_TYPE] = "multipart/form-data; boundary=XyZabc";
+			auto upload = new MemoryDataStream;
+			request.uploads["file"] = upload;
+
+			formMultipartParser(request, nullptr, PARSE_DATASTART);
+			for(unsigned pos = 0; pos < body.length(); pos += chunkSize) {
+				unsigned length = std::min(chunkSize, body.length() - pos);
+				assert(formMultipartParser(request, &body[pos], length) == length);
+			}
+			formMultipartParser(request, nullptr, PARSE_DATAEND);
+			assert(request.args == nullptr);
+
+			auto& params = request.postParams;
+			assert(params.count() == 2);
+			assert(params["title"] == "My Upload");
+			assert(params.contains("empty") && params["empty"].length() == 0);
+			assert(upload->available() == int(fileContent.length()));
+			assert(memcmp(upload->getStreamPointer(), fileContent.c_str(), fileContent.length()) == 0);
+		}
+
+		HttpRequest request;
+		request.headers[HTTP_HEADER_CONTENT_TYPE] = "multipart/form-data";
+		formMultipartParser(request, nullptr, PARSE_DATASTART);
+		assert(request.args == nullptr);
+		assert(formMultipartParser(request, body.c_str(), body.length()) == 0);
+	}
+}
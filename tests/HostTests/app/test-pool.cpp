@@ -0,0 +1,143 @@
+#include "common.h"
+#include <Data/MemoryPool.h>
+#include <Network/Http/HttpServerConnection.h>
+#include <Network/Http/HttpHeaderBuilder.h>
+#include <Services/Profiling/ElapseTimer.h>
+
+#if defined(ARCH_HOST) && defined(__linux__)
+#include <malloc.h>
+#endif
+
+static void printHeap(const char* tag)
+{
+#if defined(ARCH_HOST) && defined(__linux__)
+	auto mi = mallinfo();
+	debug_i("%s: heap used %u, free chunks %u", tag, mi.uordblks, mi.ordblks);
+#else
+	debug_i("%s: heap free %u", tag, system_get_free_heap_size());
+#endif
+}
+
+// Value which changes if the amount of heap in use changes
+static size_t heapUsage()
+{
+#if defined(ARCH_HOST) && defined(__linux__)
+	return mallinfo().uordblks;
+#else
+	return system_get_free_heap_size();
+#endif
+}
+
+// Emulate what a server connection does with incoming headers
+static void parseHeaders(HttpHeaderBuilder& builder, HttpHeaders& headers)
+{
+	static const char* const fields[][2] = {
+		{"Host", "192.168.1.10"},
+		{"User-Agent", "Mozilla/5.0 (X11; Linux x86_64; rv:68.0) Gecko/20100101 Firefox/68.0"},
+		{"Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8"},
+		{"Accept-Encoding", "gzip, deflate"},
+		{"Connection", "keep-alive"},
+	};
+
+	for(auto& field : fields) {
+		builder.onHeaderField(field[0], strlen(field[0]));
+		builder.onHeaderValue(headers, field[1], strlen(field[1]));
+	}
+	assert(headers.count() == ARRAY_SIZE(fields));
+	builder.reset();
+	headers.clear();
+}
+
+/*
+ * Simulate many short-lived connections. Whilst warming up, these are interleaved with long-lived
+ * allocations such as an application might make, which pin heap blocks between the connection
+ * buffers. Connections come from the pool if it has been reserved, otherwise from the heap.
+ */
+static unsigned runRequests(unsigned requestCount, unsigned warmupCount)
+{
+	bool pooled = HttpServerConnection::getPool().capacity() != 0;
+	Vector<String> longLived;
+	HttpHeaderBuilder pooledBuilder;
+	size_t warmUsage = 0;
+	// Connections aren't opened, so only need somewhere to store callbacks
+	tcp_pcb pcb = {};
+
+	ElapseTimer elapse;
+	for(unsigned i = 0; i < requestCount; ++i) {
+		if(i == warmupCount) {
+			warmUsage = heapUsage();
+		}
+
+		auto connection = new HttpServerConnection(&pcb);
+		assert(HttpServerConnection::getPool().contains(connection) == pooled);
+		HttpHeaders headers;
+		if(pooled) {
+			parseHeaders(pooledBuilder, headers);
+		} else {
+			auto builder = new HttpHeaderBuilder;
+			parseHeaders(*builder, headers);
+			delete builder;
+		}
+		delete connection;
+
+		if(i < warmupCount && i % 10 == 0) {
+			longLived.add(String(i) + " some application data");
+		}
+	}
+	auto elapsed = elapse.elapsed();
+
+	printHeap(pooled ? "Pooled" : "Heap");
+	debug_i("%u requests took %u us", requestCount, elapsed);
+
+	if(pooled) {
+		// Heap usage must not grow once steady state is reached
+		assert(heapUsage() == warmUsage);
+	}
+
+	return elapsed;
+}
+
+void test_pool()
+{
+	startTest("Memory pool");
+	{
+		MemoryPool pool;
+		assert(pool.initialise(13, 3));
+		assert(pool.getBlockSize() == 16);
+		auto b1 = pool.allocate(13);
+		auto b2 = pool.allocate(16);
+		auto b3 = pool.allocate(1);
+		assert(b1 != nullptr && b2 != nullptr && b3 != nullptr);
+		// Blocks must be usable for any type, such as double or uint64_t
+		for(auto b : {b1, b2, b3}) {
+			assert(uintptr_t(b) % alignof(max_align_t) == 0);
+		}
+		assert(pool.allocate(1) == nullptr);
+		assert(pool.available() == 0);
+		// Cannot resize whilst in use
+		assert(!pool.initialise(8, 2));
+		assert(pool.release(b2));
+		assert(pool.allocate(17) == nullptr);
+		assert(pool.allocate(4) == b2);
+		int x;
+		assert(!pool.release(&x));
+		pool.release(b1);
+		pool.release(b2);
+		pool.release(b3);
+		assert(pool.used() == 0);
+		assert(pool.initialise(8, 2));
+	}
+
+	startTest("HTTP connection heap usage");
+	{
+		const unsigned requestCount = 10000;
+		printHeap("Start");
+		assert(HttpServerConnection::getPool().capacity() == 0);
+		auto heapTime = runRequests(requestCount, 100);
+
+		bool ok = HttpServerConnection::reservePool(4);
+		assert(ok);
+		auto poolTime = runRequests(requestCount, 100);
+		debug_i("Pooled connections took %u%% of the time", poolTime * 100 / std::max(heapTime, 1U));
+	}
+}
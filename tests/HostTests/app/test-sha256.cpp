@@ -0,0 +1,44 @@
+#include "common.h"
+#include <Data/Sha256.h>
+#include <Data/HexString.h>
+
+static String getHash(const Sha256& sha)
+{
+	uint8_t hash[SHA256_SIZE];
+	sha.getHash(hash);
+	return makeHexString(hash, sizeof(hash));
+}
+
+void test_sha256()
+{
+	startTest("SHA-256 test vectors");
+	{
+		Sha256 sha;
+		assert(getHash(sha) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+
+		sha.update("abc", 3);
+		assert(getHash(sha) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+		sha.reset();
+		const char* text = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+		sha.update(text, strlen(text));
+		assert(getHash(sha) == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	}
+
+	startTest("SHA-256 incremental update");
+	{
+		// One million 'a', added in uneven pieces as they would arrive from the network
+		char block[997];
+		memset(block, 'a', sizeof(block));
+		Sha256 sha;
+		unsigned remain = 1000000;
+		for(unsigned n = 1; remain != 0; n = (n * 7) % sizeof(block) + 1) {
+			n = std::min(n, remain);
+			sha.update(block, n);
+			remain -= n;
+		}
+		String hash = getHash(sha);
+		debug_i("hash = %s", hash.c_str());
+		assert(hash == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	}
+}
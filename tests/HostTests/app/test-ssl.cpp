@@ -0,0 +1,97 @@
+#include "common.h"
+#include <Network/Ssl/SslSessionCache.h>
+
+static void storeSession(SslSessionCache& cache, const String& key, uint8_t value, unsigned length = 32)
+{
+	uint8_t id[32];
+	memset(id, value, sizeof(id));
+	cache.store(key, id, length);
+}
+
+// Returns the value a session was stored with, or -1 if not cached
+static int loadSession(SslSessionCache& cache, const String& key)
+{
+	SslSessionId session;
+	if(!cache.load(key, session)) {
+		return -1;
+	}
+	return session.getValue()[0];
+}
+
+static String hostKey(unsigned i)
+{
+	return String("host") + i + ":443";
+}
+
+void test_ssl()
+{
+	startTest("SSL session cache insert and hit");
+	{
+		SslSessionCache cache;
+		assert(cache.count() == 0);
+		assert(loadSession(cache, "a:443") == -1);
+
+		storeSession(cache, "a:443", 1);
+		assert(cache.count() == 1);
+		SslSessionId session;
+		assert(cache.load("a:443", session));
+		assert(session.getLength() == 32);
+		assert(session.getValue()[31] == 1);
+		// Port is part of the key
+		assert(loadSession(cache, "a:8443") == -1);
+	}
+
+	startTest("SSL session cache eviction order");
+	{
+		SslSessionCache cache;
+		for(unsigned i = 0; i < SSL_SESSION_CACHE_SIZE; ++i) {
+			storeSession(cache, hostKey(i), i + 1);
+		}
+		assert(cache.count() == SSL_SESSION_CACHE_SIZE);
+
+		// Using the oldest entry makes the next oldest the one to go
+		assert(loadSession(cache, hostKey(0)) == 1);
+		storeSession(cache, "new:443", 100);
+		assert(cache.count() == SSL_SESSION_CACHE_SIZE);
+		assert(loadSession(cache, hostKey(1)) == -1);
+		assert(loadSession(cache, "new:443") == 100);
+		assert(loadSession(cache, hostKey(0)) == 1);
+		for(unsigned i = 2; i < SSL_SESSION_CACHE_SIZE; ++i) {
+			assert(loadSession(cache, hostKey(i)) == int(i + 1));
+		}
+
+		// Entries loaded since make new:443 the least recently used
+		storeSession(cache, "newer:443", 101);
+		assert(loadSession(cache, "new:443") == -1);
+		assert(loadSession(cache, hostKey(0)) == 1);
+	}
+
+	startTest("SSL session cache replacement and removal");
+	{
+		SslSessionCache cache;
+		storeSession(cache, "a:443", 1);
+		storeSession(cache, "b:443", 2);
+
+		// Updating an entry doesn't add another
+		storeSession(cache, "a:443", 3, 16);
+		assert(cache.count() == 2);
+		SslSessionId session;
+		assert(cache.load("a:443", session));
+		assert(session.getLength() == 16);
+		assert(session.getValue()[0] == 3);
+
+		// An empty session ID removes the entry
+		storeSession(cache, "a:443", 4, 0);
+		assert(cache.count() == 1);
+		assert(loadSession(cache, "a:443") == -1);
+
+		cache.remove("b:443");
+		assert(cache.count() == 0);
+		assert(loadSession(cache, "b:443") == -1);
+
+		storeSession(cache, "c:443", 5);
+		cache.clear();
+		assert(cache.count() == 0);
+		assert(loadSession(cache, "c:443") == -1);
+	}
+}
@@ -0,0 +1,107 @@
+#include "common.h"
+#include <Network/TcpZeroCopy.h>
+#include <Data/Stream/LimitedMemoryStream.h>
+
+// Records when it's been deleted
+class TrackedStream : public MemoryDataStream
+{
+public:
+	TrackedStream(bool& deleted) : deleted(deleted)
+	{
+		deleted = false;
+	}
+
+	~TrackedStream()
+	{
+		deleted = true;
+	}
+
+private:
+	bool& deleted;
+};
+
+void test_tcp()
+{
+	startTest("Stream memory access");
+	{
+		MemoryDataStream mem;
+		mem.print(_F("Hello"));
+		mem.seek(1);
+		mem.print(_F(" world"));
+		// Appending doesn't move the read position
+		assert(mem.available() == 10);
+
+		const char* data;
+		size_t len = mem.getMemoryBlock(data);
+		assert(len == 10);
+		assert(memcmp(data, "ello world", len) == 0);
+
+		// Exposed memory cannot be reallocated
+		assert(mem.print(_F("!")) == 0);
+		assert(mem.available() == 10);
+		assert(mem.getStreamPointer() == data);
+
+		LimitedMemoryStream limited(16);
+		limited.print(_F("0123456789"));
+		limited.seek(4);
+		len = limited.getMemoryBlock(data);
+		assert(len == 6);
+		assert(memcmp(data, "456789", len) == 0);
+	}
+
+	startTest("Zero-copy stream release");
+	{
+		tcp_pcb pcb = {};
+		pcb.snd_lbb = 0xFFFFFF00;
+		pcb.lastack = 0xFFFFFE00;
+
+		// Stream not referenced by the TCP stack is deleted immediately
+		bool deleted;
+		IDataSourceStream* stream = new TrackedStream(deleted);
+		TcpConnection::releaseStream(stream);
+		assert(stream == nullptr);
+		assert(deleted);
+
+		// Referenced stream is kept until all data has been acknowledged
+		stream = new TrackedStream(deleted);
+		auto referenced = stream;
+		TcpZeroCopy::add(&pcb, stream);
+		pcb.snd_lbb += 0x200; // Sequence numbers wrap
+		TcpZeroCopy::add(&pcb, stream);
+		assert(TcpZeroCopy::pending(&pcb));
+		TcpConnection::releaseStream(stream);
+		assert(stream == nullptr);
+		assert(!deleted);
+
+		pcb.lastack = 0xFFFFFF00;
+		TcpZeroCopy::remove(&pcb, false);
+		assert(TcpZeroCopy::pending(&pcb));
+		assert(!deleted);
+
+		pcb.lastack = pcb.snd_lbb;
+		TcpZeroCopy::remove(&pcb, false);
+		assert(!TcpZeroCopy::pending(&pcb));
+		assert(deleted);
+		assert(!TcpZeroCopy::release(referenced));
+
+		// Stream still owned by the application isn't deleted when acknowledged
+		bool ownedDeleted;
+		auto owned = new TrackedStream(ownedDeleted);
+		TcpZeroCopy::add(&pcb, owned);
+		pcb.snd_lbb += 100;
+		pcb.lastack = pcb.snd_lbb;
+		TcpZeroCopy::remove(&pcb, false);
+		assert(!ownedDeleted);
+		delete owned;
+
+		// Aborted connection releases everything without accessing the pcb
+		stream = new TrackedStream(deleted);
+		pcb.snd_lbb += 100;
+		TcpZeroCopy::add(&pcb, stream);
+		TcpConnection::releaseStream(stream);
+		assert(!deleted);
+		TcpZeroCopy::remove(&pcb, true);
+		assert(!TcpZeroCopy::pending(&pcb));
+		assert(deleted);
+	}
+}
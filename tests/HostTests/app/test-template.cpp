@@ -0,0 +1,95 @@
+#include "common.h"
+#include <Data/Stream/TemplateFlashMemoryStream.h>
+#include <Data/Stream/CompiledTemplateStream.h>
+#include <Services/Profiling/ElapseTimer.h>
+
+IMPORT_FSTR(templateSource, "resource/template.html");
+IMPORT_FSTR(templateCompiled, "out/templates/template.html.bin");
+
+// Read stream in blocks of the given size
+static String readStream(IDataSourceStream& stream, size_t blockSize)
+{
+	String s;
+	char buf[256];
+	while(!stream.isFinished()) {
+		auto len = stream.readMemoryBlock(buf, std::min(blockSize, sizeof(buf)));
+		if(len == 0) {
+			break;
+		}
+		s.concat(buf, len);
+		stream.seek(len);
+	}
+	return s;
+}
+
+void test_template()
+{
+	TemplateVariables vars;
+	vars["title"] = "Sming";
+	vars["heap"] = "12345";
+	vars["uptime"] = "1h";
+	vars["brace"] = "}";
+	vars["other"] = "not used";
+
+	startTest("Compiled template matches TemplateStream");
+	{
+		TemplateFlashMemoryStream tmpl(templateSource);
+		tmpl.setVars(vars);
+		String expected = readStream(tmpl, 256);
+
+		CompiledTemplateStream compiled(templateCompiled);
+		assert(compiled.getStreamType() == eSST_Template);
+		assert(compiled.getVarCount() == 6);
+		compiled.setVars(vars);
+		assert(compiled.available() == int(expected.length()));
+		for(unsigned blockSize = 1; blockSize <= 256; blockSize += 17) {
+			CompiledTemplateStream stream(templateCompiled);
+			stream.setVars(vars);
+			assert(readStream(stream, blockSize) == expected);
+		}
+	}
+
+	startTest("Compiled template large values");
+	{
+		// TemplateStream requires values to fit in the read buffer, but these are streamed in pieces
+		String content;
+		for(unsigned i = 0; i < 200; ++i) {
+			content += "Line ";
+			content += i;
+			content += '\n';
+		}
+
+		CompiledTemplateStream compiled(templateCompiled);
+		compiled.setVars(vars);
+		assert(compiled.setVar("content", content));
+		assert(!compiled.setVar("not a var", "x"));
+		auto length = compiled.available();
+		String output = readStream(compiled, 64);
+		assert(output.length() == unsigned(length));
+		assert(output.indexOf(content) > 0);
+		assert(compiled.available() == 0);
+	}
+
+	startTest("Template variable lookup performance");
+	{
+		const unsigned iterations = 1000;
+		ElapseTimer elapse;
+		for(unsigned i = 0; i < iterations; ++i) {
+			TemplateFlashMemoryStream tmpl(templateSource);
+			tmpl.setVars(vars);
+			readStream(tmpl, 256);
+		}
+		auto scanTime = elapse.elapsed();
+
+		elapse.start();
+		for(unsigned i = 0; i < iterations; ++i) {
+			CompiledTemplateStream compiled(templateCompiled);
+			compiled.setVars(vars);
+			readStream(compiled, 256);
+		}
+		auto compiledTime = elapse.elapsed();
+
+		debug_i("Render %u x %u bytes: scanned %u us, compiled %u us", iterations, templateSource.length(), scanTime,
+				compiledTime);
+	}
+}
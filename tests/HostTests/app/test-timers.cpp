@@ -0,0 +1,184 @@
+#include "common.h"
+#include <Services/Profiling/ElapseTimer.h>
+#include <Services/Profiling/EventProfiler.h>
+
+#ifdef ARCH_HOST
+#include <hostlib/eventloop.h>
+#include <hostlib/threads.h>
+#include <unistd.h>
+
+// Wakes the main loop from another thread, as the UART server does
+class NotifyThread : public CThread
+{
+protected:
+	void* thread_routine() override
+	{
+		usleep(10000);
+		host_event_notify();
+		return nullptr;
+	}
+};
+#endif
+
+static unsigned timerCallCount;
+
+static void IRAM_ATTR timerCallback()
+{
+	++timerCallCount;
+}
+
+void test_timers()
+{
+	const unsigned timerCount = 4000;
+
+	startTest("Timer arm/disarm performance");
+	{
+		auto timers = new Timer[timerCount];
+		ElapseTimer elapse;
+
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].initializeMs(1000 + (os_random() % 60000), timerCallback).start();
+		}
+		auto armTime = elapse.elapsed();
+		debug_i("Armed %u timers in %u us", timerCount, armTime);
+#ifdef ARCH_HOST
+		assert(host_timer_count() == timerCount);
+#endif
+
+		// Re-arm half the timers, as happens with timeouts which get restarted
+		elapse.start();
+		for(unsigned i = 0; i < timerCount; i += 2) {
+			timers[i].restart();
+		}
+		auto rearmTime = elapse.elapsed();
+		debug_i("Re-armed %u timers in %u us", timerCount / 2, rearmTime);
+
+#ifdef ARCH_HOST
+		elapse.start();
+		const unsigned serviceCount = 1000;
+		for(unsigned i = 0; i < serviceCount; ++i) {
+			host_service_timers();
+			(void)host_timer_sleeptime();
+		}
+		debug_i("%u timer service calls took %u us", serviceCount, elapse.elapsed());
+		assert(timerCallCount == 0);
+#endif
+
+		elapse.start();
+		for(unsigned i = 0; i < timerCount; ++i) {
+			timers[i].stop();
+		}
+		auto disarmTime = elapse.elapsed();
+		debug_i("Disarmed %u timers in %u us", timerCount, disarmTime);
+#ifdef ARCH_HOST
+		assert(host_timer_count() == 0);
+#endif
+
+		delete[] timers;
+	}
+
+#ifdef ARCH_HOST
+	startTest("Timer expiry order");
+	{
+		SimpleTimer timers[8];
+		static uint8_t order[ARRAY_SIZE(timers)];
+		static unsigned count;
+		for(unsigned i = 0; i < ARRAY_SIZE(timers); ++i) {
+			timers[i].setCallback([](void* arg) { order[count++] = uint32_t(arg); }, reinterpret_cast<void*>(i));
+			// Reverse order of expiry
+			timers[i].startUs(800 - (i * 100));
+		}
+
+		os_delay_us(1000);
+		host_service_timers();
+		debug_i("%u timers fired", count);
+		assert(count == ARRAY_SIZE(timers));
+		for(unsigned i = 0; i < count; ++i) {
+			assert(order[i] == ARRAY_SIZE(timers) - 1 - i);
+		}
+		assert(host_timer_count() == 0);
+	}
+#endif
+
+#ifdef ARCH_HOST
+	startTest("Event wait");
+	{
+		ElapseTimer elapse;
+		host_event_wait(0);
+		auto elapsed = elapse.elapsed();
+		debug_i("Wait(0) took %u us", elapsed);
+		assert(elapsed < 5000);
+
+		elapse.start();
+		host_event_wait(20000);
+		elapsed = elapse.elapsed();
+		debug_i("Wait(20000) took %u us", elapsed);
+		assert(elapsed >= 20000 && elapsed < 200000);
+
+		// Notification from another thread ends the wait early
+		NotifyThread thread;
+		elapse.start();
+		bool started = thread.execute();
+		assert(started);
+		host_event_wait(1000000);
+		elapsed = elapse.elapsed();
+		debug_i("Notified wait took %u us", elapsed);
+		assert(elapsed >= 5000 && elapsed < 500000);
+
+		// Readable descriptor ends the wait immediately
+		int fds[2];
+		int res = pipe(fds);
+		assert(res == 0);
+		if(host_event_add_fd(fds[0])) {
+			char c = 0;
+			res = write(fds[1], &c, 1);
+			assert(res == 1);
+			elapse.start();
+			host_event_wait(1000000);
+			elapsed = elapse.elapsed();
+			debug_i("Readable fd wait took %u us", elapsed);
+			assert(elapsed < 500000);
+			host_event_remove_fd(fds[0]);
+		}
+		close(fds[0]);
+		close(fds[1]);
+	}
+#endif
+
+	startTest("Event profiler");
+	{
+		EventProfiler::reset();
+		EventProfiler::setSlowThreshold(1000);
+
+		const unsigned durations[] = {3, 15, 16, 100, 999, 1000, 250000, 5000000};
+		for(auto duration : durations) {
+			EventProfiler::record(EVENT_TYPE_TIMER, &durations[0], duration);
+		}
+		// Overflow the trace buffer so only the most recent are kept
+		for(unsigned i = 0; i < EVENT_PROFILER_TRACE_SIZE; ++i) {
+			EventProfiler::record(EVENT_TYPE_TASK, reinterpret_cast<void*>(i), 2000 + i);
+		}
+
+		auto& timerStats = EventProfiler::getStats(EVENT_TYPE_TIMER);
+		assert(timerStats.count == ARRAY_SIZE(durations));
+		assert(timerStats.maxTime == 5000000);
+		assert(timerStats.histogram[0] == 2);
+		assert(timerStats.histogram[1] == 1);
+		assert(timerStats.histogram[3] == 1);
+		assert(timerStats.histogram[6] == 2);
+		assert(timerStats.histogram[EVENT_PROFILER_BUCKETS - 1] == 2);
+
+		assert(EventProfiler::getTraceCount() == EVENT_PROFILER_TRACE_SIZE);
+		for(unsigned i = 0; i < EVENT_PROFILER_TRACE_SIZE; ++i) {
+			auto& trace = EventProfiler::getTrace(i);
+			assert(trace.type == EVENT_TYPE_TASK);
+			assert(trace.duration == 2000 + i);
+		}
+
+		EventProfiler::printTo(Serial);
+
+		EventProfiler::reset();
+		EventProfiler::setSlowThreshold(EVENT_PROFILER_SLOW_THRESHOLD);
+		assert(EventProfiler::getStats(EVENT_TYPE_TIMER).count == 0);
+	}
+}
@@ -0,0 +1,195 @@
+#include "common.h"
+#include <Network/Http/Websocket/WebsocketFrameStream.h>
+#include <Services/Profiling/ElapseTimer.h>
+
+// Decode a frame header, returning its length
+static size_t decodeHeader(const uint8_t* data, uint8_t& opcode, bool& isFin, uint64_t& payloadLength,
+						   const uint8_t*& maskKey)
+{
+	size_t i = 0;
+	isFin = (data[i] & 0x80) != 0;
+	opcode = data[i++] & 0x0F;
+	bool masked = (data[i] & 0x80) != 0;
+	payloadLength = data[i++] & 0x7F;
+	unsigned extLength = (payloadLength == 126) ? 2 : (payloadLength == 127) ? 8 : 0;
+	if(extLength != 0) {
+		payloadLength = 0;
+		while(extLength-- != 0) {
+			payloadLength = (payloadLength << 8) | data[i++];
+		}
+	}
+	maskKey = masked ? &data[i] : nullptr;
+	return masked ? i + 4 : i;
+}
+
+// Reference implementation
+static void maskBytes(uint8_t* data, size_t length, const uint8_t* maskKey)
+{
+	for(size_t i = 0; i < length; ++i) {
+		data[i] ^= maskKey[i % 4];
+	}
+}
+
+void test_websocket()
+{
+	startTest("Websocket frame header encoding");
+	{
+		const struct {
+			size_t payloadLength;
+			size_t headerLength;
+		} lengths[] = {{0, 2}, {125, 2}, {126, 4}, {0xFFFF, 4}, {0x10000, 10}, {0x12345678, 10}};
+
+		for(auto& l : lengths) {
+			for(unsigned useMask = 0; useMask < 2; ++useMask) {
+				uint8_t header[WEBSOCKET_MAX_HEADER_SIZE];
+				uint8_t maskKey[4];
+				auto headerLength = WebsocketConnection::encodeHeader(WS_FRAME_BINARY, l.payloadLength, true,
+																	  useMask ? maskKey : nullptr, header);
+				assert(headerLength == l.headerLength + (useMask ? 4 : 0));
+
+				uint8_t opcode;
+				bool isFin;
+				uint64_t payloadLength;
+				const uint8_t* decodedKey;
+				assert(decodeHeader(header, opcode, isFin, payloadLength, decodedKey) == headerLength);
+				assert(opcode == WS_FRAME_BINARY);
+				assert(isFin);
+				assert(payloadLength == l.payloadLength);
+				assert((decodedKey != nullptr) == bool(useMask));
+				if(useMask) {
+					assert(memcmp(decodedKey, maskKey, 4) == 0);
+				}
+			}
+		}
+	}
+
+	startTest("Websocket payload masking");
+	{
+		const uint8_t maskKey[] = {0x12, 0x34, 0x56, 0x78};
+		uint8_t data[64];
+		uint8_t expected[sizeof(data)];
+		// Check all alignments and lengths against byte-wise masking
+		for(unsigned offset = 0; offset < 8; ++offset) {
+			for(unsigned length = 0; length <= sizeof(data) - offset; ++length) {
+				for(unsigned i = 0; i < sizeof(data); ++i) {
+					data[i] = expected[i] = os_random();
+				}
+				WebsocketConnection::maskPayload(&data[offset], length, maskKey);
+				maskBytes(&expected[offset], length, maskKey);
+				assert(memcmp(data, expected, sizeof(data)) == 0);
+			}
+		}
+	}
+
+	startTest("Websocket payload masking resumed part way through");
+	{
+		const uint8_t maskKey[] = {0x12, 0x34, 0x56, 0x78};
+		uint8_t data[64];
+		uint8_t expected[sizeof(data)];
+		// Payload received in two pieces, as ws_parser may deliver it
+		for(unsigned split = 0; split <= sizeof(data); ++split) {
+			for(unsigned i = 0; i < sizeof(data); ++i) {
+				data[i] = expected[i] = os_random();
+			}
+			WebsocketConnection::maskPayload(data, split, maskKey);
+			WebsocketConnection::maskPayload(&data[split], sizeof(data) - split, maskKey, split);
+			maskBytes(expected, sizeof(expected), maskKey);
+			assert(memcmp(data, expected, sizeof(data)) == 0);
+		}
+	}
+
+	startTest("Websocket masking performance");
+	{
+		const uint8_t maskKey[] = {0xA5, 0x5A, 0xC3, 0x3C};
+		const unsigned bufferSize = 8192;
+		const unsigned iterations = 100;
+		auto buffer = new uint8_t[bufferSize + 1];
+
+		ElapseTimer elapse;
+		for(unsigned i = 0; i < iterations; ++i) {
+			maskBytes(buffer, bufferSize, maskKey);
+		}
+		auto byteTime = elapse.elapsed();
+
+		elapse.start();
+		for(unsigned i = 0; i < iterations; ++i) {
+			WebsocketConnection::maskPayload(buffer, bufferSize, maskKey);
+		}
+		auto wordTime = elapse.elapsed();
+
+		elapse.start();
+		for(unsigned i = 0; i < iterations; ++i) {
+			WebsocketConnection::maskPayload(buffer + 1, bufferSize, maskKey);
+		}
+		auto unalignedTime = elapse.elapsed();
+
+		debug_i("Masking %u x %u bytes: byte-wise %u us, word-wise %u us, unaligned %u us", iterations, bufferSize,
+				byteTime, wordTime, unalignedTime);
+
+		delete[] buffer;
+	}
+
+	startTest("Websocket fragmented stream");
+	{
+		const unsigned messageLength = (WEBSOCKET_FRAGMENT_SIZE * 2) + 100;
+		auto message = new uint8_t[messageLength];
+		for(unsigned i = 0; i < messageLength; ++i) {
+			message[i] = os_random();
+		}
+
+		for(unsigned useMask = 0; useMask < 2; ++useMask) {
+			auto source = new MemoryDataStream;
+			source->write(message, messageLength);
+			WebsocketFrameStream stream(source, WS_FRAME_TEXT, useMask);
+			int encodedLength = stream.available();
+			assert(encodedLength > int(messageLength));
+
+			// Read in odd-sized blocks, as the TCP stack would
+			MemoryDataStream output;
+			char buf[300];
+			while(!stream.isFinished()) {
+				auto len = stream.readMemoryBlock(buf, sizeof(buf));
+				assert(len != 0);
+				output.write(reinterpret_cast<uint8_t*>(buf), len);
+				stream.seek(len);
+				assert(stream.available() == encodedLength - output.available());
+			}
+
+			auto data = reinterpret_cast<uint8_t*>(const_cast<char*>(output.getStreamPointer()));
+			unsigned dataLength = output.available();
+			size_t pos = 0;
+			size_t messagePos = 0;
+			unsigned frameCount = 0;
+			bool isFin = false;
+			while(!isFin) {
+				uint8_t opcode;
+				uint64_t payloadLength;
+				const uint8_t* maskKey;
+				pos += decodeHeader(&data[pos], opcode, isFin, payloadLength, maskKey);
+				assert(opcode == (frameCount == 0 ? WS_FRAME_TEXT : 0));
+				assert(payloadLength <= WEBSOCKET_FRAGMENT_SIZE);
+				assert((maskKey != nullptr) == bool(useMask));
+				if(maskKey != nullptr) {
+					uint8_t key[4];
+					memcpy(key, maskKey, 4);
+					WebsocketConnection::maskPayload(&data[pos], payloadLength, key);
+				}
+				assert(memcmp(&data[pos], &message[messagePos], payloadLength) == 0);
+				pos += payloadLength;
+				messagePos += payloadLength;
+				++frameCount;
+			}
+			debug_i("%u byte message sent as %u frames, %u bytes", messageLength, frameCount, dataLength);
+			assert(frameCount == 3);
+			assert(pos == dataLength);
+			assert(dataLength == unsigned(encodedLength));
+			assert(messagePos == messageLength);
+		}
+
+		delete[] message;
+
+		// An empty message is still sent as one frame
+		WebsocketFrameStream empty(new MemoryDataStream, WS_FRAME_TEXT, false);
+		assert(empty.available() == 2);
+	}
+}